@@ -15,8 +15,19 @@
 #include "options.h"
 #include "ixfr.h"
 
-/* draft-ietf-dnsop-rfc2845bis-06, section 5.3.1 says to sign every packet */
-#define AXFR_TSIG_SIGN_EVERY_NTH	0	/* tsig sign every N packets. */
+/*
+ * See if the message completes a batch of xfr-tsig-sign-every messages,
+ * RFC 8945 section 5.3.1 allows up to 99 unsigned messages in between.
+ */
+int
+xfr_tsig_batch_full(struct nsd* nsd, struct query* query)
+{
+	/* the messages since the last signature, with this one */
+	size_t count = 1;
+	if(!query->tsig_prepare_it)
+		count += query->tsig.updates_since_last_prepare;
+	return count >= (size_t)nsd->options->xfr_tsig_sign_every;
+}
 
 query_state_type
 query_axfr(struct nsd *nsd, struct query *query, int wstats)
@@ -169,15 +180,8 @@ return_answer:
 	ARCOUNT_SET(query->packet, 0);
 
 	/* check if it needs tsig signatures */
-	if(query->tsig.status == TSIG_OK) {
-#if AXFR_TSIG_SIGN_EVERY_NTH > 0
-		if(query->tsig.updates_since_last_prepare >= AXFR_TSIG_SIGN_EVERY_NTH) {
-#endif
-			query->tsig_sign_it = 1;
-#if AXFR_TSIG_SIGN_EVERY_NTH > 0
-		}
-#endif
-	}
+	if(query->tsig.status == TSIG_OK && xfr_tsig_batch_full(nsd, query))
+		query->tsig_sign_it = 1;
 	query_clear_compression_tables(query);
 	return QUERY_IN_AXFR;
 }
@@ -283,6 +287,26 @@ static int axfr_ixfr_can_admit_query(struct nsd* nsd, struct query* q)
 	return 1;
 }
 
+/*
+ * A zone that is loaded when it is first queried, and is not loaded yet,
+ * has its zonefile read, and the transfer is answered with SERVFAIL, so
+ * that the secondary tries again.
+ */
+static int
+axfr_ixfr_zone_not_loaded(struct nsd *nsd, struct query *q)
+{
+	zone_type* zone = namedb_find_zone(nsd->db, q->qname);
+	if(!zone || (zone->apex && zone->soa_rrset) ||
+		!query_request_zone_load(nsd, zone))
+		return 0;
+	RCODE_SET(q->packet, RCODE_SERVFAIL);
+	/* RFC 8914 - Extended DNS Errors
+	 * 4.15. Extended DNS Error Code 14 - Not Ready */
+	ASSIGN_EDE_CODE_AND_STRING_LITERAL(q->edns.ede,
+		EDE_NOT_READY, "Zone is configured but not loaded");
+	return 1;
+}
+
 /*
  * Answer if this is an AXFR or IXFR query.
  */
@@ -293,7 +317,8 @@ answer_axfr_ixfr(struct nsd *nsd, struct query *q)
 	switch (q->qtype) {
 	case TYPE_AXFR:
 		if (q->tcp) {
-			if(!axfr_ixfr_can_admit_query(nsd, q))
+			if(!axfr_ixfr_can_admit_query(nsd, q) ||
+				axfr_ixfr_zone_not_loaded(nsd, q))
 				return QUERY_PROCESSED;
 			return query_axfr(nsd, q, 1);
 		}
@@ -301,7 +326,8 @@ answer_axfr_ixfr(struct nsd *nsd, struct query *q)
 		RCODE_SET(q->packet, RCODE_IMPL);
 		return QUERY_PROCESSED;
 	case TYPE_IXFR:
-		if(!axfr_ixfr_can_admit_query(nsd, q)) {
+		if(!axfr_ixfr_can_admit_query(nsd, q) ||
+			axfr_ixfr_zone_not_loaded(nsd, q)) {
 			/* get rid of authority section, if present */
 			NSCOUNT_SET(q->packet, 0);
 			ARCOUNT_SET(q->packet, 0);
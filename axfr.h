@@ -21,5 +21,7 @@
 
 query_state_type answer_axfr_ixfr(struct nsd *nsd, struct query *q);
 query_state_type query_axfr(struct nsd *nsd, struct query *query, int wstats);
+/* true if the xfr message has to be TSIG signed to end a batch */
+int xfr_tsig_batch_full(struct nsd* nsd, struct query* query);
 
 #endif /* AXFR_H */
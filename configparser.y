@@ -20,6 +20,7 @@
 #include "dname.h"
 #include "tsig.h"
 #include "rrl.h"
+#include "dns.h"
 
 int yylex(void);
 
@@ -37,6 +38,10 @@ static int parse_catalog_role(const char *str, int *role);
 static int parse_expire_expr(const char *str, long long *num, uint8_t *expr);
 static int parse_number(const char *str, long long *num);
 static int parse_range(const char *str, long long *low, long long *high);
+static int parse_qtype(const char *str, int *qtype);
+static int parse_rcode(const char *str, int *rcode);
+static void append_dnstap_filter(struct dnstap_filter_list **list,
+	uint16_t num, const dname_type *zone);
 
 struct component {
 	struct component *next;
@@ -118,6 +123,8 @@ struct component {
 %token VAR_RELOAD_CONFIG
 %token VAR_ZONEFILES_CHECK
 %token VAR_ZONEFILES_WRITE
+%token VAR_ZONEFILES_WRITE_BACKGROUND
+%token VAR_ZONEFILES_LAZY_LOAD
 %token VAR_RRL_SIZE
 %token VAR_RRL_RATELIMIT
 %token VAR_RRL_SLIP
@@ -137,7 +144,16 @@ struct component {
 %token <llng> VAR_SERVER_CPU_AFFINITY
 %token VAR_DROP_UPDATES
 %token VAR_XFRD_TCP_MAX
+%token VAR_NSEC3_PRECOMPILE_WORKERS
+%token VAR_NSEC3_HASH_CACHE_SIZE
+%token VAR_DB_HUGE_PAGES
 %token VAR_XFRD_TCP_PIPELINE
+%token VAR_XFRD_PRIMARY_RATE_LIMIT
+%token VAR_XFRD_STARTUP_SPREAD
+%token VAR_XFRD_CATALOG_REFRESH_RATE
+%token VAR_XFRD_NOTIFY_MAX
+%token VAR_XFRD_NOTIFY_RATE_LIMIT
+%token VAR_XFR_TSIG_SIGN_EVERY
 
 /* dnstap */
 %token VAR_DNSTAP
@@ -155,6 +171,12 @@ struct component {
 %token VAR_DNSTAP_VERSION
 %token VAR_DNSTAP_LOG_AUTH_QUERY_MESSAGES
 %token VAR_DNSTAP_LOG_AUTH_RESPONSE_MESSAGES
+%token VAR_DNSTAP_SAMPLE_RATE
+%token VAR_DNSTAP_LOG_ZONE
+%token VAR_DNSTAP_LOG_QTYPE
+%token VAR_DNSTAP_LOG_RCODE
+%token VAR_DNSTAP_LOG_MIN_RESPONSE_SIZE
+%token VAR_DNSTAP_LOG_TRUNCATED
 
 /* remote-control */
 %token VAR_REMOTE_CONTROL
@@ -201,12 +223,14 @@ struct component {
 %token VAR_MIN_RETRY_TIME
 %token VAR_MIN_EXPIRE_TIME
 %token VAR_MULTI_PRIMARY_CHECK
+%token VAR_PROBE_PRIMARIES
 %token VAR_SIZE_LIMIT_XFR
 %token VAR_ZONESTATS
 %token VAR_INCLUDE_PATTERN
 %token VAR_STORE_IXFR
 %token VAR_IXFR_SIZE
 %token VAR_IXFR_NUMBER
+%token VAR_IXFR_BINARY
 %token VAR_CREATE_IXFR
 %token VAR_CATALOG
 %token VAR_CATALOG_MEMBER_PATTERN
@@ -452,6 +476,10 @@ server_option:
     { cfg_parser->opt->zonefiles_check = $2; }
   | VAR_ZONEFILES_WRITE number
     { cfg_parser->opt->zonefiles_write = (int)$2; }
+  | VAR_ZONEFILES_WRITE_BACKGROUND boolean
+    { cfg_parser->opt->zonefiles_write_background = $2; }
+  | VAR_ZONEFILES_LAZY_LOAD boolean
+    { cfg_parser->opt->zonefiles_lazy_load = $2; }
   | VAR_LOG_TIME_ASCII boolean
     {
       cfg_parser->opt->log_time_ascii = $2;
@@ -519,6 +547,44 @@ server_option:
     { cfg_parser->opt->xfrd_tcp_max = (int)$2; }
   | VAR_XFRD_TCP_PIPELINE number
     { cfg_parser->opt->xfrd_tcp_pipeline = (int)$2; }
+  | VAR_XFRD_PRIMARY_RATE_LIMIT number
+    { cfg_parser->opt->xfrd_primary_rate_limit = (int)$2; }
+  | VAR_XFRD_STARTUP_SPREAD boolean
+    { cfg_parser->opt->xfrd_startup_spread = $2; }
+  | VAR_XFRD_CATALOG_REFRESH_RATE number
+    { cfg_parser->opt->xfrd_catalog_refresh_rate = (int)$2; }
+  | VAR_XFRD_NOTIFY_MAX number
+    {
+      if ($2 > 0) {
+        cfg_parser->opt->xfrd_notify_max = (int)$2;
+      } else {
+        yyerror("expected a number greater than zero");
+      }
+    }
+  | VAR_XFRD_NOTIFY_RATE_LIMIT number
+    { cfg_parser->opt->xfrd_notify_rate_limit = (int)$2; }
+  | VAR_XFR_TSIG_SIGN_EVERY number
+    {
+      /* RFC 8945 allows at most 99 unsigned messages in a row */
+      if ($2 > 0 && $2 <= 100) {
+        cfg_parser->opt->xfr_tsig_sign_every = (int)$2;
+      } else {
+        yyerror("expected a number from 1 to 100");
+      }
+    }
+  | VAR_NSEC3_PRECOMPILE_WORKERS number
+    { cfg_parser->opt->nsec3_precompile_workers = (int)$2; }
+  | VAR_NSEC3_HASH_CACHE_SIZE number
+    {
+      /* an entry is about 300 bytes, in every server process */
+      if ($2 >= 0 && $2 <= 262144) {
+        cfg_parser->opt->nsec3_hash_cache_size = (size_t)$2;
+      } else {
+        yyerror("expected a number from 0 to 262144");
+      }
+    }
+  | VAR_DB_HUGE_PAGES boolean
+    { cfg_parser->opt->db_huge_pages = $2; }
   | VAR_CPU_AFFINITY cpus
     {
       cfg_parser->opt->cpu_affinity = $2;
@@ -673,6 +739,47 @@ dnstap_option:
     { cfg_parser->opt->dnstap_log_auth_query_messages = $2; }
   | VAR_DNSTAP_LOG_AUTH_RESPONSE_MESSAGES boolean
     { cfg_parser->opt->dnstap_log_auth_response_messages = $2; }
+  | VAR_DNSTAP_SAMPLE_RATE number
+    {
+      if ($2 > 0) {
+        cfg_parser->opt->dnstap_sample_rate = (int)$2;
+      } else {
+        yyerror("expected a number greater than zero");
+      }
+    }
+  | VAR_DNSTAP_LOG_ZONE STRING
+    {
+      const dname_type* zone = dname_parse(cfg_parser->opt->region, $2);
+      if(zone) {
+        append_dnstap_filter(&cfg_parser->opt->dnstap_log_zones, 0, zone);
+      } else {
+        yyerror("bad zone name %s", $2);
+      }
+    }
+  | VAR_DNSTAP_LOG_QTYPE STRING
+    {
+      int qtype;
+      if(parse_qtype($2, &qtype)) {
+        append_dnstap_filter(&cfg_parser->opt->dnstap_log_qtypes,
+          (uint16_t)qtype, NULL);
+      } else {
+        yyerror("expected a query type, like A or ANY");
+      }
+    }
+  | VAR_DNSTAP_LOG_RCODE STRING
+    {
+      int rcode;
+      if(parse_rcode($2, &rcode)) {
+        append_dnstap_filter(&cfg_parser->opt->dnstap_log_rcodes,
+          (uint16_t)rcode, NULL);
+      } else {
+        yyerror("expected a rcode, like NOERROR or REFUSED");
+      }
+    }
+  | VAR_DNSTAP_LOG_MIN_RESPONSE_SIZE number
+    { cfg_parser->opt->dnstap_log_min_response_size = (int)$2; }
+  | VAR_DNSTAP_LOG_TRUNCATED boolean
+    { cfg_parser->opt->dnstap_log_truncated = $2; }
   ;
 
 remote_control:
@@ -928,6 +1035,8 @@ pattern_or_zone_option:
     }
   | VAR_MULTI_PRIMARY_CHECK boolean
     { cfg_parser->pattern->multi_primary_check = (int)$2; }
+  | VAR_PROBE_PRIMARIES boolean
+    { cfg_parser->pattern->probe_primaries = (int)$2; }
   | VAR_INCLUDE_PATTERN STRING
     { config_apply_pattern(cfg_parser->pattern, $2); }
   | VAR_REQUEST_XFR STRING STRING
@@ -1053,6 +1162,8 @@ pattern_or_zone_option:
       cfg_parser->pattern->ixfr_number = $2;
       cfg_parser->pattern->ixfr_number_is_default = 0;
     }
+  | VAR_IXFR_BINARY boolean
+    { cfg_parser->pattern->ixfr_binary = $2; }
   | VAR_CREATE_IXFR boolean
     {
       cfg_parser->pattern->create_ixfr = $2;
@@ -1347,4 +1458,55 @@ parse_catalog_role(const char *str, int *role)
 	return 1;
 }
 
+static int
+parse_qtype(const char *str, int *qtype)
+{
+	/* the query types are not in the rrtype table */
+	if(strcasecmp(str, "ANY") == 0) {
+		*qtype = TYPE_ANY;
+	} else if(strcasecmp(str, "AXFR") == 0) {
+		*qtype = TYPE_AXFR;
+	} else if(strcasecmp(str, "IXFR") == 0) {
+		*qtype = TYPE_IXFR;
+	} else {
+		*qtype = rrtype_from_string(str);
+		if(*qtype == 0)
+			return 0;
+	}
+	return 1;
+}
+
+static int
+parse_rcode(const char *str, int *rcode)
+{
+	const char* rcstr[] = {"NOERROR", "FORMERR", "SERVFAIL", "NXDOMAIN",
+	    "NOTIMP", "REFUSED", "YXDOMAIN", "YXRRSET", "NXRRSET", "NOTAUTH",
+	    "NOTZONE"
+	};
+	long long num;
+	size_t i;
+	for(i=0; i<sizeof(rcstr)/sizeof(rcstr[0]); i++) {
+		if(strcasecmp(str, rcstr[i]) == 0) {
+			*rcode = (int)i;
+			return 1;
+		}
+	}
+	/* the rcode in the header is 4 bits */
+	if(!parse_number(str, &num) || num < 0 || num > 15)
+		return 0;
+	*rcode = (int)num;
+	return 1;
+}
 
+static void
+append_dnstap_filter(struct dnstap_filter_list **list, uint16_t num,
+	const dname_type *zone)
+{
+	struct dnstap_filter_list *elem = region_alloc_zero(
+		cfg_parser->opt->region, sizeof(*elem));
+	elem->num = num;
+	elem->zone = zone;
+	while(*list)
+		list = &(*list)->next;
+	*list = elem;
+}
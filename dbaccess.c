@@ -78,6 +78,7 @@ namedb_zone_create(namedb_type* db, const dname_type* dname,
 	zone->logstr = NULL;
 	zone->mtime.tv_sec = 0;
 	zone->mtime.tv_nsec = 0;
+	zone->writer_pid = 0;
 	zone->zonestatid = 0;
 	zone->is_secure = 0;
 	zone->is_changed = 0;
@@ -85,6 +86,8 @@ namedb_zone_create(namedb_type* db, const dname_type* dname,
 	zone->is_skipped = 0;
 	zone->is_checked = 0;
 	zone->is_bad = 0;
+	zone->is_load_tried = 0;
+	zone->is_write_queued = 0;
 	zone->is_ok = 1;
 	return zone;
 }
@@ -139,12 +142,17 @@ namedb_open (struct nsd_options* opt)
 	 */
 	region_type* db_region;
 
-	(void)opt;
-
 #ifdef USE_MMAP_ALLOC
 	db_region = region_create_custom(mmap_alloc, mmap_free, MMAP_ALLOC_CHUNK_SIZE,
 		MMAP_ALLOC_LARGE_OBJECT_SIZE, MMAP_ALLOC_INITIAL_CLEANUP_SIZE, 1);
 #else /* !USE_MMAP_ALLOC */
+#ifdef HAVE_MMAP
+	if(opt && opt->db_huge_pages)
+		db_region = region_create_custom(hugepage_alloc, hugepage_free,
+			HUGEPAGE_CHUNK_SIZE, DEFAULT_LARGE_OBJECT_SIZE,
+			DEFAULT_INITIAL_CLEANUP_SIZE, 1);
+	else
+#endif /* HAVE_MMAP */
 	db_region = region_create_custom(xalloc, free, DEFAULT_CHUNK_SIZE,
 		DEFAULT_LARGE_OBJECT_SIZE, DEFAULT_INITIAL_CLEANUP_SIZE, 1);
 #endif /* !USE_MMAP_ALLOC */
@@ -154,6 +162,7 @@ namedb_open (struct nsd_options* opt)
 	db->zonetree = radix_tree_create(db->region);
 	db->diff_skip = 0;
 	db->diff_pos = 0;
+	db->nsec3_workers = opt?opt->nsec3_precompile_workers:1;
 
 	if (gettimeofday(&(db->diff_timestamp), NULL) != 0) {
 		log_msg(LOG_ERR, "unable to load namedb: cannot initialize timestamp");
@@ -325,15 +334,37 @@ void namedb_check_zonefile(struct nsd* nsd, udb_base* taskudb,
 	if(!zone) {
 		zone = namedb_zone_create(nsd->db, dname, zopt);
 	}
+	zone->is_load_tried = 1;
 	namedb_read_zonefile(nsd, zone, taskudb, last_task);
 }
 
+/** see if the zonefile is read later, when the zone is queried */
+static int
+namedb_zonefile_is_lazy(struct nsd* nsd, struct zone_options* zopt)
+{
+	zone_type* zone;
+	const dname_type* dname = (const dname_type*)zopt->node.key;
+	if(!nsd->options->zonefiles_lazy_load || zone_is_slave(zopt) ||
+		!zopt->pattern->zonefile)
+		return 0;
+	zone = namedb_find_zone(nsd->db, dname);
+	if(!zone) {
+		/* register the zone, so queries for it can find it */
+		(void)namedb_zone_create(nsd->db, dname, zopt);
+		return 1;
+	}
+	/* once it was read, the zonefile is checked like other zones */
+	return !zone->soa_rrset && !zone->is_load_tried;
+}
+
 void namedb_check_zonefiles(struct nsd* nsd, struct nsd_options* opt,
 	udb_base* taskudb, udb_ptr* last_task)
 {
 	struct zone_options* zo;
 	/* check all zones in opt, create if not exist in main db */
 	RBTREE_FOR(zo, struct zone_options*, opt->zone_options) {
+		if(namedb_zonefile_is_lazy(nsd, zo))
+			continue;
 		namedb_check_zonefile(nsd, taskudb, last_task, zo);
 		if(nsd->signal_hint_shutdown) break;
 	}
@@ -10,7 +10,9 @@
 #include "config.h"
 
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <stdlib.h>
@@ -25,6 +27,8 @@
 
 /* pathname directory separator character */
 #define PATHSEP '/'
+/* stdio buffer size for the background zonefile writer */
+#define ZONEFILE_WRITE_BUFSIZE (1024*1024)
 
 /** add an rdata (uncompressed) to the destination */
 static size_t
@@ -130,7 +134,8 @@ print_header(zone_type* zone, FILE* out, time_t* now, const char* logs)
 }
 
 static int
-write_to_zonefile(zone_type* zone, const char* filename, const char* logs)
+write_to_zonefile(zone_type* zone, const char* filename, const char* logs,
+	int sync)
 {
 	time_t now = time(0);
 	FILE *out = fopen(filename, "w");
@@ -139,6 +144,9 @@ write_to_zonefile(zone_type* zone, const char* filename, const char* logs)
 			zone->opts->name, filename, strerror(errno));
 		return 0;
 	}
+	/* with a large buffer, the zone is written with few big writes */
+	if(sync)
+		(void)setvbuf(out, NULL, _IOFBF, ZONEFILE_WRITE_BUFSIZE);
 	if(!print_header(zone, out, &now, logs)) {
 		fclose(out);
 		log_msg(LOG_ERR, "There was an error printing "
@@ -149,6 +157,12 @@ write_to_zonefile(zone_type* zone, const char* filename, const char* logs)
 		fclose(out);
 		return 0;
 	}
+	if(sync && (fflush(out) != 0 || fsync(fileno(out)) != 0)) {
+		log_msg(LOG_ERR, "cannot write zone %s to file %s: fsync: %s",
+			zone->opts->name, filename, strerror(errno));
+		fclose(out);
+		return 0;
+	}
 	if(fclose(out) != 0) {
 		log_msg(LOG_ERR, "cannot write zone %s to file %s: fclose: %s",
 			zone->opts->name, filename, strerror(errno));
@@ -210,8 +224,9 @@ create_path_components(const char* path, int* notexist)
 	return 1;
 }
 
-void
-namedb_write_zonefile(struct nsd* nsd, struct zone_options* zopt)
+/** see if the zone has to be written to its zonefile, returns the zone */
+static zone_type*
+zonefile_write_needed(struct nsd* nsd, struct zone_options* zopt)
 {
 	const char* zfile;
 	int notexist = 0;
@@ -219,24 +234,87 @@ namedb_write_zonefile(struct nsd* nsd, struct zone_options* zopt)
 	/* if no zone exists, it has no contents or it has no zonefile
 	 * configured, then no need to write data to disk */
 	if(!zopt->pattern->zonefile)
-		return;
+		return NULL;
 	zone = namedb_find_zone(nsd->db, (const dname_type*)zopt->node.key);
 	if(!zone || !zone->apex || !zone->soa_rrset)
-		return;
+		return NULL;
 	/* write if file does not exist, or if changed */
 	/* so, determine filename, create directory components, check exist*/
 	zfile = config_make_zonefile(zopt, nsd);
 	if(!create_path_components(zfile, &notexist)) {
 		log_msg(LOG_ERR, "could not write zone %s to file %s because "
 			"the path could not be created", zopt->name, zfile);
-		return;
+		return NULL;
 	}
-
 	/* if not changed, do not write. */
-	if(notexist || zone->is_changed) {
+	if(!notexist && !zone->is_changed)
+		return NULL;
+	/* if a background writer is still writing the zone, skip it, the
+	 * zone stays changed and is written the next time.  The writer
+	 * pid is cleared when main reaps the writer. */
+	if(zone->writer_pid != 0) {
+		VERBOSITY(1, (LOG_INFO, "zone %s is still being written by "
+			"process %d, write it later", zopt->name,
+			(int)zone->writer_pid));
+		return NULL;
+	}
+	return zone;
+}
+
+/** write zonefile from the background writer, sets mtime to the stamp */
+static int
+zonefile_write_synced(struct nsd* nsd, zone_type* zone,
+	struct timespec* stamp)
+{
+	const char* zfile = config_make_zonefile(zone->opts, nsd);
+	char bakfile[4096];
+	struct timeval tv[2];
+	/* the temporary file is unique to this writer */
+	snprintf(bakfile, sizeof(bakfile), "%s~%d", zfile, (int)getpid());
+	if(!write_to_zonefile(zone, bakfile, zone->logstr, 1)) {
+		(void)unlink(bakfile); /* delete failed file */
+		return 0; /* error already printed */
+	}
+	/* the reload has set the zone mtime to the stamp, give the file
+	 * the same mtime so it is not read in again */
+	tv[0].tv_sec = stamp->tv_sec;
+	tv[0].tv_usec = stamp->tv_nsec/1000;
+	tv[1] = tv[0];
+	if(utimes(bakfile, tv) == -1) {
+		log_msg(LOG_ERR, "utimes(%s) failed: %s", bakfile,
+			strerror(errno));
+		(void)unlink(bakfile);
+		return 0;
+	}
+	if(rename(bakfile, zfile) == -1) {
+		log_msg(LOG_ERR, "rename(%s to %s) failed: %s",
+			bakfile, zfile, strerror(errno));
+		(void)unlink(bakfile); /* delete failed file */
+		return 0;
+	}
+	if(zone->is_changed) {
+		struct timespec lag;
+		get_time(&lag);
+		timespec_subtract(&lag, &zone->mtime);
+		VERBOSITY(2, (LOG_INFO, "zone %s written to file %s, "
+			"%lld msec after change", zone->opts->name, zfile,
+			(long long)lag.tv_sec*1000 + lag.tv_nsec/1000000));
+	}
+	return 1;
+}
+
+/** write the zonefile, in this process */
+static void
+namedb_write_zonefile_now(struct nsd* nsd, struct zone_options* zopt)
+{
+	const char* zfile;
+	int notexist = 0;
+	zone_type* zone = zonefile_write_needed(nsd, zopt);
+	if(zone) {
 		char logs[4096];
 		char bakfile[4096];
 		struct timespec mtime;
+		zfile = config_make_zonefile(zopt, nsd);
 		/* write to zfile~ first, then rename if that works */
 		snprintf(bakfile, sizeof(bakfile), "%s~", zfile);
 		if(zone->logstr)
@@ -245,7 +323,7 @@ namedb_write_zonefile(struct nsd* nsd, struct zone_options* zopt)
 			logs[0] = 0;
 		VERBOSITY(1, (LOG_INFO, "writing zone %s to file %s",
 			zone->opts->name, zfile));
-		if(!write_to_zonefile(zone, bakfile, logs)) {
+		if(!write_to_zonefile(zone, bakfile, logs, 0)) {
 			(void)unlink(bakfile); /* delete failed file */
 			return; /* error already printed */
 		}
@@ -275,11 +353,224 @@ namedb_write_zonefile(struct nsd* nsd, struct zone_options* zopt)
 	}
 }
 
+/*
+ * A background zonefile writer that has not been reaped. The zones are
+ * kept by name, they can be deleted before the writer exits.
+ */
+struct zonefile_writer {
+	struct zonefile_writer* next;
+	pid_t pid;
+	size_t num;
+	const dname_type** zones;
+	region_type* region;
+};
+
+/** queue the zone for the background writer. It is forked when the
+ * reload has processed its tasks, and writes the latest zone contents */
+static void
+namedb_write_zonefile_queue(struct nsd* nsd, struct zone_options* zopt)
+{
+	zone_type* zone = zonefile_write_needed(nsd, zopt);
+	if(!zone || zone->is_write_queued)
+		return;
+	zone->is_write_queued = 1;
+	nsd->zonefile_write_queued++;
+}
+
+/** remember the writer, main reaps it and sees if it failed */
+static void
+zonefile_writer_add(struct nsd* nsd, pid_t pid, zone_type** zones,
+	size_t num)
+{
+	struct zonefile_writer* w = (struct zonefile_writer*)xalloc_zero(
+		sizeof(*w));
+	size_t i;
+	w->pid = pid;
+	w->num = num;
+	w->region = region_create(xalloc, free);
+	w->zones = (const dname_type**)region_alloc_array(w->region, num,
+		sizeof(dname_type*));
+	for(i=0; i<num; i++)
+		w->zones[i] = dname_copy(w->region, domain_dname(
+			zones[i]->apex));
+	w->next = nsd->zonefile_writers;
+	nsd->zonefile_writers = w;
+}
+
+/** the writer is done, with success or not */
+static void
+zonefile_writer_done(struct nsd* nsd, struct zonefile_writer* w, int failed)
+{
+	size_t i;
+	for(i=0; i<w->num; i++) {
+		zone_type* zone = namedb_find_zone(nsd->db, w->zones[i]);
+		if(!zone || zone->writer_pid != w->pid)
+			continue;
+		zone->writer_pid = 0;
+		/* the changes are written the next time */
+		if(failed)
+			zone->is_changed = 1;
+	}
+	region_destroy(w->region);
+	free(w);
+}
+
+/** see if the writer failed from its exit status, and log it */
+static int
+zonefile_writer_failed(struct zonefile_writer* w, int status)
+{
+	if(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+		return 0;
+	log_msg(LOG_ERR, "zonefile writer %d failed with status %d, %u "
+		"zonefiles are written again later", (int)w->pid, status,
+		(unsigned)w->num);
+	return 1;
+}
+
+int
+namedb_zonefile_writer_exited(struct nsd* nsd, pid_t pid, int status)
+{
+	struct zonefile_writer** p;
+	for(p = &nsd->zonefile_writers; *p; p = &(*p)->next) {
+		struct zonefile_writer* w = *p;
+		if(w->pid != pid)
+			continue;
+		*p = w->next;
+		zonefile_writer_done(nsd, w, zonefile_writer_failed(w, status));
+		return 1;
+	}
+	return 0;
+}
+
+/** reap the writers that have exited. The reload ignores SIGCHLD at its
+ * start, the status of a writer that exited then is lost, and its zones
+ * are written again */
+static void
+zonefile_writers_check(struct nsd* nsd)
+{
+	struct zonefile_writer** p = &nsd->zonefile_writers;
+	while(*p) {
+		struct zonefile_writer* w = *p;
+		int status = 0, failed;
+		pid_t r = waitpid(w->pid, &status, WNOHANG);
+		if(r == 0 || (r == -1 && errno == EINTR)) {
+			p = &w->next; /* still running */
+			continue;
+		}
+		*p = w->next;
+		if(r == -1) {
+			VERBOSITY(2, (LOG_INFO, "zonefile writer %d exit "
+				"status lost, %u zonefiles are written again",
+				(int)w->pid, (unsigned)w->num));
+			failed = 1;
+		} else	failed = zonefile_writer_failed(w, status);
+		zonefile_writer_done(nsd, w, failed);
+	}
+}
+
+/** write the queued zonefiles from a forked process. The reload continues
+ * with the zones marked as written, the child has a copy of the zone
+ * data. If the child fails, main marks the zones as changed again. */
+void
+namedb_write_zonefiles_start(struct nsd* nsd)
+{
+	struct radnode* n;
+	zone_type** zones;
+	size_t i, num = 0;
+	struct timespec stamp;
+	pid_t pid;
+
+	zonefile_writers_check(nsd);
+	if(nsd->zonefile_write_queued == 0)
+		return;
+	zones = (zone_type**)xalloc_array_zero(
+		(size_t)nsd->zonefile_write_queued, sizeof(zone_type*));
+	for(n = radix_first(nsd->db->zonetree); n; n = radix_next(n)) {
+		zone_type* zone = (zone_type*)n->elem;
+		if(!zone->is_write_queued)
+			continue;
+		zone->is_write_queued = 0;
+		/* the zone can have expired or be deleted since */
+		if(!zone->apex || !zone->soa_rrset ||
+			num == (size_t)nsd->zonefile_write_queued)
+			continue;
+		zones[num++] = zone;
+	}
+	nsd->zonefile_write_queued = 0;
+	if(num == 0) {
+		free(zones);
+		return;
+	}
+	/* utimes sets the file mtime with microsecond precision */
+	get_time(&stamp);
+	stamp.tv_nsec -= stamp.tv_nsec%1000;
+
+	VERBOSITY(1, (LOG_INFO, "writing %u zonefiles in the background",
+		(unsigned)num));
+	pid = fork();
+	if(pid == -1) {
+		log_msg(LOG_ERR, "fork zonefile writer failed: %s, writing "
+			"zonefiles in the reload", strerror(errno));
+		for(i=0; i<num; i++)
+			namedb_write_zonefile_now(nsd, zones[i]->opts);
+		free(zones);
+		return;
+	} else if(pid == 0) {
+		/* child, main checks the exit status */
+		int failed = 0;
+		for(i=0; i<num; i++) {
+			if(!zonefile_write_synced(nsd, zones[i], &stamp))
+				failed++;
+		}
+		if(failed)
+			log_msg(LOG_ERR, "zonefile writer: %d of %u zonefiles "
+				"failed to write", failed, (unsigned)num);
+		_exit(failed?1:0);
+	}
+	/* parent, the zones are written by the child. The is_changed flag
+	 * is cleared now, so that a change during the write is not lost,
+	 * and set again if the writer fails. With no filename the file is
+	 * read again only if it is newer than the stamp */
+	zonefile_writer_add(nsd, pid, zones, num);
+	for(i=0; i<num; i++) {
+		zone_type* zone = zones[i];
+		zone->is_changed = 0;
+		zone->mtime = stamp;
+		zone->writer_pid = pid;
+		if(zone->filename)
+			region_recycle(nsd->db->region, zone->filename,
+				strlen(zone->filename)+1);
+		zone->filename = NULL;
+		if(zone->logstr)
+			region_recycle(nsd->db->region, zone->logstr,
+				strlen(zone->logstr)+1);
+		zone->logstr = NULL;
+		if(zone_is_ixfr_enabled(zone) && zone->ixfr)
+			ixfr_write_to_file(zone, config_make_zonefile(
+				zone->opts, nsd));
+	}
+	free(zones);
+}
+
+void
+namedb_write_zonefile(struct nsd* nsd, struct zone_options* zopt)
+{
+	if(nsd->options->zonefiles_write_background)
+		namedb_write_zonefile_queue(nsd, zopt);
+	else	namedb_write_zonefile_now(nsd, zopt);
+}
+
 void
 namedb_write_zonefiles(struct nsd* nsd, struct nsd_options* options)
 {
 	struct zone_options* zo;
+	if(options->zonefiles_write_background) {
+		RBTREE_FOR(zo, struct zone_options*, options->zone_options) {
+			namedb_write_zonefile_queue(nsd, zo);
+		}
+		return;
+	}
 	RBTREE_FOR(zo, struct zone_options*, options->zone_options) {
-		namedb_write_zonefile(nsd, zo);
+		namedb_write_zonefile_now(nsd, zo);
 	}
 }
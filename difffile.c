@@ -236,17 +236,9 @@ diff_read_str(FILE* in, char* buf, size_t len)
 static void
 add_rdata_to_recyclebin(namedb_type* db, rr_type* rr)
 {
-	/* add rdatas to recycle bin. */
-	size_t i;
-	for(i=0; i<rr->rdata_count; i++)
-	{
-		if(!rdata_atom_is_domain(rr->type, i))
-			region_recycle(db->region, rr->rdatas[i].data,
-				rdata_atom_size(rr->rdatas[i])
-				+ sizeof(uint16_t));
-	}
+	/* add rdatas to recycle bin, the atoms are one block */
 	region_recycle(db->region, rr->rdatas,
-		sizeof(rdata_atom_type)*rr->rdata_count);
+		rdata_atoms_size(rr->type, rr->rdatas, rr->rdata_count));
 }
 
 /* this routine determines if below a domain there exist names with
@@ -1356,8 +1348,10 @@ apply_ixfr_for_zone(nsd_type* nsd, zone_type* zone, FILE* in,
 	{
 		int is_axfr=0, delete_mode=0, rr_count=0, softfail=0;
 		struct ixfr_store* ixfr_store = NULL, ixfr_store_mem;
+		struct timespec apply_start, apply_end;
 
 		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "processing xfr: %s", zone_buf));
+		get_time(&apply_start);
 		if(zone_is_ixfr_enabled(zone))
 			ixfr_store = ixfr_store_start(zone, &ixfr_store_mem);
 		/* read and apply all of the parts */
@@ -1384,8 +1378,18 @@ apply_ixfr_for_zone(nsd_type* nsd, zone_type* zone, FILE* in,
 				zone_buf);
 			snprintf(log_buf, sizeof(log_buf), "error reading log");
 		}
+		get_time(&apply_end);
+		timespec_subtract(&apply_end, &apply_start);
+		timespec_add(&nsd->xfr_stats.apply_time, &apply_end);
+		nsd->xfr_stats.xfrs++;
 #ifdef NSEC3
-		prehash_zone(nsd->db, zone);
+		if(taskudb) {
+			/* in the reload process, postpone the prehash, so that
+			 * consecutive transfers for the zone prehash once */
+			nsd->prehash_pending = zone;
+		} else {
+			prehash_zone(nsd->db, zone);
+		}
 #endif /* NSEC3 */
 		zone->is_changed = 1;
 		zone->is_updated = 1;
@@ -2134,9 +2138,34 @@ task_process_apply_xfr(struct nsd* nsd, udb_base* udb, udb_ptr *last_task,
 }
 
 
+void
+task_process_prehash_pending(struct nsd* nsd)
+{
+	struct timespec start, end;
+	zone_type* zone = nsd->prehash_pending;
+	if(!zone)
+		return;
+	nsd->prehash_pending = NULL;
+	get_time(&start);
+#ifdef NSEC3
+	prehash_zone(nsd->db, zone);
+#endif /* NSEC3 */
+	get_time(&end);
+	timespec_subtract(&end, &start);
+	timespec_add(&nsd->xfr_stats.prehash_time, &end);
+	nsd->xfr_stats.zones++;
+}
+
 void task_process_in_reload(struct nsd* nsd, udb_base* udb, udb_ptr *last_task,
         udb_ptr* task)
 {
+	/* a postponed prehash is done before other tasks look at the zone
+	 * contents, unless this task is another transfer for that zone */
+	if(nsd->prehash_pending && (TASKLIST(task)->task_type != task_apply_xfr
+		|| namedb_find_zone(nsd->db, TASKLIST(task)->zname) !=
+		nsd->prehash_pending))
+		task_process_prehash_pending(nsd);
+
 	switch(TASKLIST(task)->task_type) {
 	case task_expire:
 		task_process_expire(nsd->db, TASKLIST(task));
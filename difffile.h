@@ -159,6 +159,9 @@ int task_new_apply_xfr(udb_base* udb, udb_ptr* last, const dname_type* zone,
 	uint32_t old_serial, uint32_t new_serial, uint64_t filenumber);
 void task_process_in_reload(struct nsd* nsd, udb_base* udb, udb_ptr *last_task,
 	udb_ptr* task);
+/* perform the NSEC3 prehash that is postponed for the last zone that
+ * had a transfer applied in the reload process, if any */
+void task_process_prehash_pending(struct nsd* nsd);
 void task_process_expire(namedb_type* db, struct task_list_d* task);
 
 #endif /* DIFFFILE_H */
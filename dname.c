@@ -99,6 +99,75 @@ dname_make_from_packet(region_type *region, buffer_type *packet,
 	return dname_make(region, buf, normalize);
 }
 
+size_t
+dname_make_in_buffer(uint8_t *buf, const uint8_t *name, const uint8_t *end,
+	uint8_t *key, size_t *keylen)
+{
+	dname_type *result = (dname_type *) buf;
+	uint8_t label_offsets[MAXDOMAINLEN/2 + 1];
+	uint8_t label_count = 0;
+	/* The labels are copied after room for the maximum number of
+	 * label offsets, and moved down once the label count is known. */
+	uint8_t *start = buf + sizeof(dname_type) + MAXDOMAINLEN/2 + 1;
+	uint8_t *dst = start;
+	const uint8_t *src = name;
+	const uint8_t *limit = end;
+	/* The radix key has the labels in reverse order, so the labels
+	 * are put in the key from the end, each preceded by a 00
+	 * 'end-of-label' byte, that is not needed for the first one. */
+	size_t kpos = MAXDOMAINLEN;
+	uint8_t *offsets;
+	size_t name_size;
+	ssize_t i;
+
+	if (limit - name > MAXDOMAINLEN)
+		limit = name + MAXDOMAINLEN;
+	while (1) {
+		uint8_t len;
+		if (src >= limit)
+			return 0;
+		len = *src++;
+		if ((len & 0xc0))
+			return 0;
+		label_offsets[label_count++] = (uint8_t) (src - 1 - name);
+		*dst++ = len;
+		if (len == 0)
+			break;
+		/* the label and the next length byte have to fit */
+		if (src + len >= limit)
+			return 0;
+		if (key) {
+			kpos -= len;
+			for (i = 0; i < len; ++i) {
+				uint8_t c = *src++;
+				*dst++ = DNAME_NORMALIZE(c);
+				key[kpos + i] = radname_char_d2r(c);
+			}
+			key[--kpos] = 0;
+		} else {
+			for (i = 0; i < len; ++i)
+				*dst++ = DNAME_NORMALIZE((unsigned char)*src++);
+		}
+	}
+
+	name_size = (size_t) (src - name);
+	result->name_size = (uint8_t) name_size;
+	result->label_count = label_count;
+	offsets = (uint8_t *) dname_label_offsets(result);
+	for (i = 0; i < label_count; ++i)
+		offsets[i] = label_offsets[label_count - i - 1];
+	memmove(offsets + label_count, start, name_size);
+	if (key) {
+		/* the root name has an empty key */
+		*keylen = 0;
+		if (kpos < MAXDOMAINLEN) {
+			*keylen = MAXDOMAINLEN - kpos - 1;
+			memmove(key, key + kpos + 1, *keylen);
+		}
+	}
+	return name_size;
+}
+
 int
 dname_make_wire_from_packet(uint8_t *buf, buffer_type *packet,
                        int allow_pointers)
@@ -78,6 +78,25 @@ int dname_make_wire_from_packet(uint8_t *buf,
 				buffer_type *packet,
 				int allow_pointers);
 
+/*
+ * Space for a domain name with the maximum number of labels and the
+ * maximum length, for dname_make_in_buffer.
+ */
+#define DNAME_MAX_SIZE (sizeof(dname_type) + MAXDOMAINLEN/2 + 1 + MAXDOMAINLEN)
+
+/*
+ * Construct a normalized domain name from the uncompressed wire format
+ * name at NAME, in one pass and without allocation, in the
+ * DNAME_MAX_SIZE bytes at BUF.  The name must end before END.
+ * If KEY is not NULL, the radix tree key of the name (see radname_d2r)
+ * is made in the same pass, in the MAXDOMAINLEN bytes at KEY, and its
+ * length is stored in KEYLEN.
+ * Returns the wire format length of the name, or 0 if it is truncated,
+ * too long or contains a compression pointer.
+ */
+size_t dname_make_in_buffer(uint8_t *buf, const uint8_t *name,
+			    const uint8_t *end, uint8_t *key, size_t *keylen);
+
 /*
  * Construct a new domain name based on the ASCII representation NAME.
  * If ORIGIN is not NULL and NAME is not terminated by a "." the
@@ -63,7 +63,6 @@
 #endif
 
 #define DNSTAP_CONTENT_TYPE		"protobuf:dnstap.Dnstap"
-#define DNSTAP_INITIAL_BUF_SIZE		256
 
 struct dt_msg {
 	void		*buf;
@@ -75,21 +74,14 @@ struct dt_msg {
 static int
 dt_pack(const Dnstap__Dnstap *d, void **buf, size_t *sz)
 {
-	ProtobufCBufferSimple sbuf;
-
-	memset(&sbuf, 0, sizeof(sbuf));
-	sbuf.base.append = protobuf_c_buffer_simple_append;
-	sbuf.len = 0;
-	sbuf.alloced = DNSTAP_INITIAL_BUF_SIZE;
-	sbuf.data = malloc(sbuf.alloced);
-	if (sbuf.data == NULL)
+	/* pack in one allocation of the exact size, fstrm frees it after
+	 * it is written, instead of growing a buffer while packing */
+	size_t len = dnstap__dnstap__get_packed_size(d);
+	uint8_t* data = malloc(len?len:1);
+	if (data == NULL)
 		return 0;
-	sbuf.must_free_data = 1;
-
-	*sz = dnstap__dnstap__pack_to_buffer(d, (ProtobufCBuffer *) &sbuf);
-	if (sbuf.data == NULL)
-		return 0;
-	*buf = sbuf.data;
+	*sz = dnstap__dnstap__pack(d, data);
+	*buf = data;
 
 	return 1;
 }
@@ -831,12 +823,15 @@ dt_msg_send_auth_query(struct dt_env *env,
 	struct sockaddr_in* local_addr,
 	struct sockaddr_in* addr,
 #endif
-	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen)
+	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen,
+	struct timeval* tv)
 {
 	struct dt_msg dm;
 	struct timeval qtime;
 
-	gettimeofday(&qtime, NULL);
+	if(tv)
+		qtime = *tv;
+	else	gettimeofday(&qtime, NULL);
 
 	/* type */
 	dt_msg_init(env, &dm, DNSTAP__MESSAGE__TYPE__AUTH_QUERY);
@@ -877,12 +872,15 @@ dt_msg_send_auth_response(struct dt_env *env,
 	struct sockaddr_in* local_addr,
 	struct sockaddr_in* addr,
 #endif
-	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen)
+	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen,
+	struct timeval* tv)
 {
 	struct dt_msg dm;
 	struct timeval rtime;
 
-	gettimeofday(&rtime, NULL);
+	if(tv)
+		rtime = *tv;
+	else	gettimeofday(&rtime, NULL);
 
 	/* type */
 	dt_msg_init(env, &dm, DNSTAP__MESSAGE__TYPE__AUTH_RESPONSE);
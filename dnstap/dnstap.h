@@ -43,6 +43,7 @@ struct nsd_options;
 struct fstrm_io;
 struct fstrm_queue;
 struct dt_tls_writer;
+struct timeval;
 
 struct dt_env {
 	/** dnstap I/O thread */
@@ -130,6 +131,7 @@ dt_delete(struct dt_env *env);
  * @param zonelen: length of zone in bytes.
  * @param pkt: query message.
  * @param pktlen: length of pkt.
+ * @param tv: time the query was received, or NULL for now.
  */
 void
 dt_msg_send_auth_query(struct dt_env *env,
@@ -140,7 +142,8 @@ dt_msg_send_auth_query(struct dt_env *env,
 	struct sockaddr_in* local_addr,
 	struct sockaddr_in* addr,
 #endif
-	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen);
+	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen,
+	struct timeval* tv);
 
 /**
  * Create and send a new dnstap "Message" event of type AUTH_RESPONSE.
@@ -152,6 +155,7 @@ dt_msg_send_auth_query(struct dt_env *env,
  * @param zonelen: length of zone in bytes.
  * @param pkt: response message.
  * @param pktlen: length of pkt.
+ * @param tv: time the response was sent, or NULL for now.
  */
 void
 dt_msg_send_auth_response(struct dt_env *env,
@@ -162,7 +166,8 @@ dt_msg_send_auth_response(struct dt_env *env,
 	struct sockaddr_in* local_addr,
 	struct sockaddr_in* addr,
 #endif
-	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen);
+	int is_tcp, uint8_t* zone, size_t zonelen, uint8_t* pkt, size_t pktlen,
+	struct timeval* tv);
 
 #endif /* USE_DNSTAP */
 
@@ -10,9 +10,18 @@
 #include "config.h"
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <signal.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS   MAP_ANON
+#endif
+#endif /* HAVE_MMAP */
 #ifndef USE_MINI_EVENT
 #  ifdef HAVE_EVENT_H
 #    include <event.h>
@@ -36,6 +45,68 @@
 
 #include "udb.h"
 #include "rrl.h"
+#include "lookup3.h"
+
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS) && defined(__ATOMIC_ACQUIRE)
+#define DT_USE_RING 1
+#endif
+
+/*
+ * The ring in shared memory between a worker and the collector. The
+ * worker writes the messages and the tail, the collector is the only
+ * reader, and writes the head. The fd_send and fd_swap halves swap at
+ * every reload, so a server process that still serves after the next
+ * reload shares its ring with a worker two generations newer. The writers
+ * hold the writer lock, with their pid, while they write in the ring; a
+ * writer that finds it taken drops the message, and counts it as busy. The positions only increase,
+ * the offset in the data is the position modulo the data size. Messages
+ * are in the format of prep_send_data, at 8 byte aligned offsets, and
+ * do not wrap around the end of the data. If a message does not fit at
+ * the end, a DT_RING_WRAP marker skips to the start.
+ */
+struct dt_ring {
+	/* read position, written by the collector */
+	uint64_t head;
+	uint8_t pad1[56];
+	/* write position, written by the worker */
+	uint64_t tail;
+	/* number of messages dropped because the ring was full */
+	uint64_t dropped;
+	/* number of messages dropped because another writer held the ring */
+	uint64_t busy;
+	/* pid of the worker that writes in the ring, or 0 */
+	uint32_t writer;
+	uint8_t pad2[36];
+	/* DT_RING_SLEEPING when the collector has drained the ring and
+	 * waits for the worker to wake it up over the socket */
+	uint32_t sleeping;
+	uint8_t pad3[60];
+};
+
+/* size of the data in a ring, after the struct dt_ring */
+#define DT_RING_DATA (DT_RING_SIZE - sizeof(struct dt_ring))
+/* marker at the end of the data, the next message is at the start */
+#define DT_RING_WRAP 0xffffffff
+/* the values of sleeping: the collector is draining the ring, it waits to
+ * be woken up, or the worker has sent it the wake up */
+#define DT_RING_AWAKE 0
+#define DT_RING_SLEEPING 1
+#define DT_RING_WOKEN 2
+/* messages in the ring are aligned to 8 bytes */
+#define DT_RING_ALIGN(x) (((x)+7)&~((size_t)7))
+/* times a worker tries to take the writer lock before it drops the message */
+#define DT_RING_LOCK_TRIES 64
+/* the collector frees up space in the ring for every so many messages */
+#define DT_RING_BATCH 64
+/* interval to log the number of dropped messages, in seconds */
+#define DT_DROPPED_LOG_INTERVAL 60
+
+/* the ring of the index */
+static struct dt_ring*
+dt_ring_get(struct dt_collector* dt_col, int i)
+{
+	return (struct dt_ring*)(dt_col->rings + (size_t)i*DT_RING_SIZE);
+}
 
 struct dt_collector* dt_collector_create(struct nsd* nsd)
 {
@@ -46,8 +117,8 @@ struct dt_collector* dt_collector_create(struct nsd* nsd)
 	dt_col->dt_env = NULL;
 	dt_col->region = region_create(xalloc, free);
 	dt_col->send_buffer = buffer_create(dt_col->region,
-		/* msglen + is_response + addrlen + is_tcp + packetlen + packet + zonelen + zone + spare + local_addr + addr */
-		4+1+4+1+4+TCP_MAX_MESSAGE_LEN+4+MAXHOSTNAMELEN + 32 +
+		/* msglen + is_response + time + addrlen + is_tcp + packetlen + packet + zonelen + zone + spare + local_addr + addr */
+		4+1+8+4+1+4+TCP_MAX_MESSAGE_LEN+4+MAXHOSTNAMELEN + 32 +
 #ifdef INET6
 		sizeof(struct sockaddr_storage) + sizeof(struct sockaddr_storage)
 #else
@@ -96,6 +167,23 @@ struct dt_collector* dt_collector_create(struct nsd* nsd)
 	}
 	nsd->dt_collector_fd_swap = nsd->dt_collector_fd_send + nsd->child_count;
 
+#ifdef DT_USE_RING
+	/* the rings, the worker that sends on dt_collector_fd_send[i]
+	 * writes in ring i */
+	dt_col->rings = (uint8_t*)mmap(NULL, (size_t)dt_col->count*DT_RING_SIZE,
+		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	if(dt_col->rings == MAP_FAILED) {
+		log_msg(LOG_ERR, "dnstap_collector: could not mmap rings, "
+			"sending over the sockets: %s", strerror(errno));
+		dt_col->rings = NULL;
+	} else {
+		for(i=0; i<dt_col->count; i++) {
+			/* the first message wakes up the collector */
+			dt_ring_get(dt_col, i)->sleeping = DT_RING_SLEEPING;
+		}
+	}
+#endif
+
 	/* open socketpair */
 	if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == -1) {
 		error("dnstap_collector: cannot create socketpair: %s",
@@ -124,6 +212,10 @@ void dt_collector_destroy(struct dt_collector* dt_col, struct nsd* nsd)
 		free(nsd->dt_collector_fd_swap);
 	nsd->dt_collector_fd_send = NULL;
 	nsd->dt_collector_fd_swap = NULL;
+#ifdef DT_USE_RING
+	if(dt_col->rings)
+		munmap(dt_col->rings, (size_t)dt_col->count*DT_RING_SIZE);
+#endif
 	region_destroy(dt_col->region);
 	free(dt_col);
 }
@@ -216,11 +308,14 @@ dt_submit_content(struct dt_env* dt_env, struct buffer* buf)
 	uint8_t* data;
 	size_t zonelen;
 	uint8_t* zone;
+	struct timeval tv;
 
 	/* parse content from buffer */
-	if(!buffer_available(buf, 4+1+4)) return;
+	if(!buffer_available(buf, 4+1+8+4)) return;
 	buffer_skip(buf, 4); /* skip msglen */
 	is_response = buffer_read_u8(buf);
+	tv.tv_sec = (time_t)buffer_read_u32(buf);
+	tv.tv_usec = (suseconds_t)buffer_read_u32(buf);
 	addrlen = buffer_read_u32(buf);
 	if(addrlen > sizeof(local_addr) || addrlen > sizeof(addr)) return;
 	if(!buffer_available(buf, 2*addrlen)) return;
@@ -246,18 +341,135 @@ dt_submit_content(struct dt_env* dt_env, struct buffer* buf)
 	/* submit it */
 	if(is_response) {
 		dt_msg_send_auth_response(dt_env, &local_addr, &addr, is_tcp, zone,
-			zonelen, data, pktlen);
+			zonelen, data, pktlen, &tv);
 	} else {
 		dt_msg_send_auth_query(dt_env, &local_addr, &addr, is_tcp, zone,
-			zonelen, data, pktlen);
+			zonelen, data, pktlen, &tv);
+	}
+}
+
+#ifdef DT_USE_RING
+/* log the number of messages that the worker dropped because its ring
+ * was full, and because the ring was busy with another writer, at most
+ * once per interval */
+static void
+dt_ring_log_dropped(struct dt_collector_input* dt_input)
+{
+	uint64_t dropped = __atomic_load_n(&dt_input->ring->dropped,
+		__ATOMIC_RELAXED);
+	uint64_t busy = __atomic_load_n(&dt_input->ring->busy,
+		__ATOMIC_RELAXED);
+	time_t now;
+	if(dropped == dt_input->dropped_logged &&
+		busy == dt_input->busy_logged)
+		return;
+	now = time(NULL);
+	if(now < dt_input->dropped_time + DT_DROPPED_LOG_INTERVAL)
+		return;
+	if(dropped != dt_input->dropped_logged)
+		log_msg(LOG_WARNING, "dnstap collector: dropped %llu messages, "
+			"the ring of a server process was full",
+			(unsigned long long)(dropped - dt_input->dropped_logged));
+	if(busy != dt_input->busy_logged)
+		log_msg(LOG_WARNING, "dnstap collector: dropped %llu messages, "
+			"the ring of a server process was held by another "
+			"server process",
+			(unsigned long long)(busy - dt_input->busy_logged));
+	dt_input->dropped_logged = dropped;
+	dt_input->busy_logged = busy;
+	dt_input->dropped_time = now;
+}
+
+/* read the messages in the ring and submit them to dnstap */
+static void
+dt_ring_drain(struct dt_collector_input* dt_input)
+{
+	struct dt_ring* ring = dt_input->ring;
+	struct dt_env* dt_env = dt_input->dt_collector->dt_env;
+	uint64_t head = ring->head, tail;
+	size_t num = 0;
+
+	/* it is awake now, the worker does not have to wake it up */
+	__atomic_store_n(&ring->sleeping, DT_RING_AWAKE, __ATOMIC_SEQ_CST);
+	while(1) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		while(head != tail) {
+			uint8_t* msg = (uint8_t*)(ring+1) +
+				(size_t)(head % DT_RING_DATA);
+			size_t space = DT_RING_DATA - (size_t)(head%DT_RING_DATA);
+			uint32_t msglen = read_uint32(msg);
+			if(msglen == DT_RING_WRAP) {
+				head += space;
+				continue;
+			}
+			if(4+(size_t)msglen > space || 4+(size_t)msglen >
+				tail - head) {
+				log_msg(LOG_ERR, "dnstap collector: ring out "
+					"of sync (msglen: %u)",
+					(unsigned int)msglen);
+				head = tail;
+				break;
+			}
+			if(dt_env) {
+				struct buffer buf;
+				buffer_create_from(&buf, msg, 4+(size_t)msglen);
+				dt_submit_content(dt_env, &buf);
+			}
+			head += DT_RING_ALIGN(4+(size_t)msglen);
+			if(++num % DT_RING_BATCH == 0) {
+				/* free up the space for the worker */
+				__atomic_store_n(&ring->head, head,
+					__ATOMIC_RELEASE);
+			}
+		}
+		__atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+		/* wait for a wakeup, but check that no message was written
+		 * before the worker could see that we sleep */
+		__atomic_store_n(&ring->sleeping, DT_RING_SLEEPING,
+			__ATOMIC_SEQ_CST);
+		if(__atomic_load_n(&ring->tail, __ATOMIC_SEQ_CST) == head)
+			break;
+		__atomic_store_n(&ring->sleeping, DT_RING_AWAKE,
+			__ATOMIC_SEQ_CST);
 	}
+	VERBOSITY(4, (LOG_INFO, "dnstap collector: drained %d msgs from ring",
+		(int)num));
+	dt_ring_log_dropped(dt_input);
 }
+#endif /* DT_USE_RING */
 
 /* handle input from worker for dnstap */
 void
 dt_handle_input(int fd, short event, void* arg)
 {
 	struct dt_collector_input* dt_input = (struct dt_collector_input*)arg;
+#ifdef DT_USE_RING
+	if((event&EV_READ) != 0 && dt_input->ring) {
+		/* the datagrams only wake us up, the messages are in the
+		 * ring */
+		ssize_t r;
+		do {
+			r = recv(fd, buffer_begin(dt_input->buffer),
+				buffer_capacity(dt_input->buffer), MSG_DONTWAIT);
+		} while(r > 0);
+		if(r == 0 || (r == -1 && errno != EAGAIN && errno != EINTR
+#ifdef EWOULDBLOCK
+			&& errno != EWOULDBLOCK
+#endif
+			)) {
+			if(r == 0)
+				log_msg(LOG_ERR, "dnstap collector: remote "
+					"closed connection");
+			else	log_msg(LOG_ERR, "dnstap collector: receive "
+					"failed: %s", strerror(errno));
+			event_base_loopexit(dt_input->dt_collector->event_base,
+				NULL);
+			return;
+		}
+		dt_ring_drain(dt_input);
+		return;
+	}
+#endif /* DT_USE_RING */
 	if((event&EV_READ) != 0) {
 		/* receive */
 		int r = recv_into_buffer(fd, dt_input->buffer);
@@ -371,8 +583,8 @@ static void dt_attach_events(struct dt_collector* dt_col, struct nsd* nsd)
 			log_msg(LOG_ERR, "dnstap collector: event_add failed");
 		
 		dt_col->inputs[i].buffer = buffer_create(dt_col->region,
-			/* msglen + is_response + addrlen + is_tcp + packetlen + packet + zonelen + zone + spare + local_addr + addr */
-			4+1+4+1+4+TCP_MAX_MESSAGE_LEN+4+MAXHOSTNAMELEN + 32 +
+			/* msglen + is_response + time + addrlen + is_tcp + packetlen + packet + zonelen + zone + spare + local_addr + addr */
+			4+1+8+4+1+4+TCP_MAX_MESSAGE_LEN+4+MAXHOSTNAMELEN + 32 +
 #ifdef INET6
 			sizeof(struct sockaddr_storage) + sizeof(struct sockaddr_storage)
 #else
@@ -381,6 +593,10 @@ static void dt_attach_events(struct dt_collector* dt_col, struct nsd* nsd)
 		);
 		assert(buffer_capacity(dt_col->inputs[i].buffer) ==
 			buffer_capacity(dt_col->send_buffer));
+#ifdef DT_USE_RING
+		if(dt_col->rings)
+			dt_col->inputs[i].ring = dt_ring_get(dt_col, i);
+#endif
 	}
 }
 
@@ -470,6 +686,7 @@ prep_send_data(struct buffer* buf, uint8_t is_response,
 	socklen_t addrlen, int is_tcp, struct buffer* packet,
 	struct zone* zone)
 {
+	struct timeval tv;
 	buffer_clear(buf);
 #ifdef INET6
 	if(local_addr->ss_family != addr->ss_family)
@@ -478,10 +695,14 @@ prep_send_data(struct buffer* buf, uint8_t is_response,
 	if(local_addr->sin_family != addr->sin_family)
 		return 0; /* must be same length to send */
 #endif
-	if(!buffer_available(buf, 4+1+4+2*addrlen+1+4+buffer_remaining(packet)))
+	if(!buffer_available(buf, 4+1+8+4+2*addrlen+1+4+buffer_remaining(packet)))
 		return 0; /* does not fit in send_buffer, log is dropped */
+	/* the time of the message, the collector may submit it later */
+	gettimeofday(&tv, NULL);
 	buffer_skip(buf, 4); /* the length of the message goes here */
 	buffer_write_u8(buf, is_response);
+	buffer_write_u32(buf, (uint32_t)tv.tv_sec);
+	buffer_write_u32(buf, (uint32_t)tv.tv_usec);
 	buffer_write_u32(buf, addrlen);
 	buffer_write(buf, local_addr, (size_t)addrlen);
 	buffer_write(buf, addr, (size_t)addrlen);
@@ -536,6 +757,240 @@ static int attempt_to_send(int s, uint8_t* data, size_t len)
 	return -1;
 }
 
+#ifdef DT_USE_RING
+/* the length of the message that prep_send_data makes */
+static size_t
+prep_send_size(socklen_t addrlen, struct buffer* packet, struct zone* zone)
+{
+	size_t len = 4+1+8+4+2*(size_t)addrlen+1+4+buffer_remaining(packet)+4;
+	if(zone && zone->apex && domain_dname(zone->apex))
+		len += domain_dname(zone->apex)->name_size;
+	return len;
+}
+
+/* take the writer lock of the ring, returns false if another worker holds
+ * it.  The lock of a worker that died holding it is taken over. */
+static int
+dt_ring_lock(struct dt_ring* ring, uint32_t mypid)
+{
+	uint32_t expect;
+	int i;
+	for(i=0; i<DT_RING_LOCK_TRIES; i++) {
+		expect = 0;
+		if(__atomic_compare_exchange_n(&ring->writer, &expect, mypid,
+			0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 1;
+	}
+	if(expect != 0 && kill((pid_t)expect, 0) == -1 && errno == ESRCH) {
+		/* the holder has exited, without a release */
+		if(__atomic_compare_exchange_n(&ring->writer, &expect, mypid,
+			0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			return 1;
+	}
+	return 0;
+}
+
+/* write the message in the ring of the worker, and wake up the collector
+ * if it sleeps.  If the ring is full, or held by another worker, the
+ * message is dropped.
+ * return 0 on success, -1 on error */
+static int
+dt_ring_submit(struct nsd* nsd, uint8_t is_response,
+#ifdef INET6
+	struct sockaddr_storage* local_addr,
+	struct sockaddr_storage* addr,
+#else
+	struct sockaddr_in* local_addr,
+	struct sockaddr_in* addr,
+#endif
+	socklen_t addrlen, int is_tcp, struct buffer* packet,
+	struct zone* zone)
+{
+	/* the worker that sends on dt_collector_fd_send[i] has ring i,
+	 * and the fd_send pointer points at the first or the second half */
+	int* fd_base = nsd->dt_collector_fd_send < nsd->dt_collector_fd_swap
+		? nsd->dt_collector_fd_send : nsd->dt_collector_fd_swap;
+	int num = (int)(nsd->dt_collector_fd_send - fd_base) +
+		nsd->this_child->child_num;
+	int fd = nsd->dt_collector_fd_send[nsd->this_child->child_num];
+	struct dt_ring* ring = dt_ring_get(nsd->dt_collector, num);
+	uint64_t head, tail;
+	size_t need, space;
+	uint32_t expect;
+	struct buffer buf;
+
+	if(!dt_ring_lock(ring, (uint32_t)nsd->this_child->pid)) {
+		__atomic_add_fetch(&ring->busy, 1, __ATOMIC_RELAXED);
+		return 0;
+	}
+	head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	tail = ring->tail;
+	need = DT_RING_ALIGN(prep_send_size(addrlen, packet, zone));
+	space = DT_RING_DATA - (size_t)(tail % DT_RING_DATA);
+	if(need > space) {
+		/* skip to the start of the ring */
+		if(tail + space + need - head > DT_RING_DATA) {
+			__atomic_add_fetch(&ring->dropped, 1,
+				__ATOMIC_RELAXED);
+			__atomic_store_n(&ring->writer, 0, __ATOMIC_RELEASE);
+			return 0;
+		}
+		write_uint32((uint8_t*)(ring+1) + (size_t)(tail%DT_RING_DATA),
+			DT_RING_WRAP);
+		tail += space;
+	} else if(tail + need - head > DT_RING_DATA) {
+		__atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&ring->writer, 0, __ATOMIC_RELEASE);
+		return 0;
+	}
+
+	buffer_create_from(&buf, (uint8_t*)(ring+1) +
+		(size_t)(tail%DT_RING_DATA), need);
+	if(prep_send_data(&buf, is_response, local_addr, addr, addrlen,
+		is_tcp, packet, zone))
+		tail += DT_RING_ALIGN(buffer_remaining(&buf));
+	__atomic_store_n(&ring->tail, tail, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&ring->writer, 0, __ATOMIC_RELEASE);
+
+	/* wake up the collector, if it sleeps and is not woken up yet */
+	expect = DT_RING_SLEEPING;
+	if(__atomic_compare_exchange_n(&ring->sleeping, &expect,
+		DT_RING_WOKEN, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+		uint8_t wake = 0;
+		ssize_t r = send(fd, &wake, 1, MSG_DONTWAIT | MSG_NOSIGNAL);
+		if(r != 1) {
+			/* the next message tries to wake it up again */
+			expect = DT_RING_WOKEN;
+			(void)__atomic_compare_exchange_n(&ring->sleeping,
+				&expect, DT_RING_SLEEPING, 0,
+				__ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+			if(r == -1 && errno != EAGAIN && errno != EINTR &&
+				errno != ENOBUFS) {
+				log_msg(LOG_ERR, "dnstap collector: send "
+					"failed: %s", strerror(errno));
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+#endif /* DT_USE_RING */
+
+/* true if the address is in the dnstap-sample-rate sample. The sample is
+ * by client address, so that the queries and responses of a client are
+ * logged together */
+static int
+dt_filter_sample(int rate,
+#ifdef INET6
+	struct sockaddr_storage* addr
+#else
+	struct sockaddr_in* addr
+#endif
+	)
+{
+	uint32_t h;
+	if(rate <= 1)
+		return 1;
+#ifdef INET6
+	if(addr->ss_family == AF_INET6)
+		h = hashlittle(&((struct sockaddr_in6*)addr)->sin6_addr,
+			sizeof(struct in6_addr), 0);
+	else
+#endif
+		h = hashlittle(&((struct sockaddr_in*)addr)->sin_addr,
+			sizeof(struct in_addr), 0);
+	return (h % (uint32_t)rate) == 0;
+}
+
+/* true if the qname is equal to or below one of the zones */
+static int
+dt_filter_zone(struct dnstap_filter_list* zones, uint8_t* qname,
+	size_t qnamelen)
+{
+	struct dnstap_filter_list* f;
+	size_t pos, i;
+	for(f = zones; f; f = f->next) {
+		const uint8_t* apex = dname_name(f->zone);
+		if(qnamelen < f->zone->name_size)
+			continue;
+		/* the apex must start at a label of the qname */
+		pos = 0;
+		while(qnamelen - pos > f->zone->name_size)
+			pos += (size_t)qname[pos]+1;
+		if(qnamelen - pos != f->zone->name_size)
+			continue;
+		for(i=0; i<f->zone->name_size; i++) {
+			if(DNAME_NORMALIZE((unsigned char)qname[pos+i]) !=
+				DNAME_NORMALIZE((unsigned char)apex[i]))
+				break;
+		}
+		if(i == f->zone->name_size)
+			return 1;
+	}
+	return 0;
+}
+
+/* true if the packet passes the dnstap log filters of the options. The
+ * zone, qtype and sample filters select the queries and responses, the
+ * rcode, truncated and response size filters select among the responses,
+ * a response is logged if it matches any of them */
+static int
+dt_filter(struct nsd_options* opt, uint8_t is_response,
+#ifdef INET6
+	struct sockaddr_storage* addr,
+#else
+	struct sockaddr_in* addr,
+#endif
+	struct buffer* packet)
+{
+	struct dnstap_filter_list* f;
+	uint8_t* wire = buffer_begin(packet);
+	size_t len = buffer_remaining(packet), pos = QHEADERSZ;
+	uint16_t qtype;
+
+	if(!dt_filter_sample(opt->dnstap_sample_rate, addr))
+		return 0;
+	if(opt->dnstap_log_zones || opt->dnstap_log_qtypes) {
+		if(len < QHEADERSZ || QDCOUNT(packet) == 0)
+			return 0;
+		/* the question section is not compressed */
+		while(pos < len && wire[pos] != 0) {
+			if((wire[pos]&0xc0))
+				return 0;
+			pos += (size_t)wire[pos]+1;
+		}
+		if(pos+1+2 > len || pos+1-QHEADERSZ > MAXDOMAINLEN)
+			return 0;
+		pos++;
+		if(opt->dnstap_log_zones && !dt_filter_zone(
+			opt->dnstap_log_zones, wire+QHEADERSZ, pos-QHEADERSZ))
+			return 0;
+		if(opt->dnstap_log_qtypes) {
+			qtype = read_uint16(wire+pos);
+			for(f = opt->dnstap_log_qtypes; f; f = f->next)
+				if(f->num == qtype)
+					break;
+			if(!f)
+				return 0;
+		}
+	}
+	if(!is_response || (!opt->dnstap_log_rcodes &&
+		!opt->dnstap_log_truncated &&
+		opt->dnstap_log_min_response_size == 0))
+		return 1;
+	if(len < QHEADERSZ)
+		return 0;
+	if(opt->dnstap_log_truncated && TC(packet))
+		return 1;
+	if(opt->dnstap_log_min_response_size != 0 &&
+		len >= (size_t)opt->dnstap_log_min_response_size)
+		return 1;
+	for(f = opt->dnstap_log_rcodes; f; f = f->next)
+		if(f->num == RCODE(packet))
+			return 1;
+	return 0;
+}
+
 void dt_collector_submit_auth_query(struct nsd* nsd,
 #ifdef INET6
 	struct sockaddr_storage* local_addr,
@@ -549,8 +1004,19 @@ void dt_collector_submit_auth_query(struct nsd* nsd,
 	if(!nsd->dt_collector) return;
 	if(!nsd->options->dnstap_log_auth_query_messages) return;
 	if(nsd->dt_collector_fd_send[nsd->this_child->child_num] == -1) return;
+	if(!dt_filter(nsd->options, 0, addr, packet)) return;
 	VERBOSITY(4, (LOG_INFO, "dnstap submit auth query"));
 
+#ifdef DT_USE_RING
+	if(nsd->dt_collector->rings) {
+		if(dt_ring_submit(nsd, 0, local_addr, addr, addrlen, is_tcp,
+			packet, NULL)) {
+			close(nsd->dt_collector_fd_send[nsd->this_child->child_num]);
+			nsd->dt_collector_fd_send[nsd->this_child->child_num] = -1;
+		}
+		return;
+	}
+#endif
 	/* marshal data into send buffer */
 	if(!prep_send_data(nsd->dt_collector->send_buffer, 0, local_addr, addr, addrlen,
 		is_tcp, packet, NULL))
@@ -581,8 +1047,19 @@ void dt_collector_submit_auth_response(struct nsd* nsd,
 	if(!nsd->dt_collector) return;
 	if(!nsd->options->dnstap_log_auth_response_messages) return;
 	if(nsd->dt_collector_fd_send[nsd->this_child->child_num] == -1) return;
+	if(!dt_filter(nsd->options, 1, addr, packet)) return;
 	VERBOSITY(4, (LOG_INFO, "dnstap submit auth response"));
 
+#ifdef DT_USE_RING
+	if(nsd->dt_collector->rings) {
+		if(dt_ring_submit(nsd, 1, local_addr, addr, addrlen, is_tcp,
+			packet, zone)) {
+			close(nsd->dt_collector_fd_send[nsd->this_child->child_num]);
+			nsd->dt_collector_fd_send[nsd->this_child->child_num] = -1;
+		}
+		return;
+	}
+#endif
 	/* marshal data into send buffer */
 	if(!prep_send_data(nsd->dt_collector->send_buffer, 1, local_addr, addr, addrlen,
 		is_tcp, packet, zone))
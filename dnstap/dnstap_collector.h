@@ -17,6 +17,11 @@ struct dt_collector_input;
 struct zone;
 struct buffer;
 struct region;
+struct dt_ring;
+
+/* size of the shared memory ring per worker, that the worker writes the
+ * messages for dnstap in, and that the collector reads them from. */
+#define DT_RING_SIZE (1024*1024)
 
 /* information for the dnstap collector process. It collects information
  * for dnstap from the worker processes.  And writes them to the dnstap
@@ -43,6 +48,10 @@ struct dt_collector {
 	struct region* region;
 	/* buffer for sending data to the collector */
 	struct buffer* send_buffer;
+	/* shared memory with a ring per worker, count of them, the workers
+	 * write the messages in the rings and the sockets only wake up the
+	 * collector. NULL if the messages are sent over the sockets. */
+	uint8_t* rings;
 };
 
 /* information per worker to get input from that worker. */
@@ -53,6 +62,16 @@ struct dt_collector_input {
 	struct event* event;
 	/* buffer to store the datagrams while they are read in */
 	struct buffer* buffer;
+	/* the ring that the worker writes in, or NULL */
+	struct dt_ring* ring;
+	/* number of messages dropped by the worker because the ring was
+	 * full, that have been logged */
+	uint64_t dropped_logged;
+	/* number of messages dropped by the worker because the ring was
+	 * held by another writer, that have been logged */
+	uint64_t busy_logged;
+	/* time the dropped messages were last logged */
+	time_t dropped_time;
 };
 
 /* create dt_collector process structure and dt_env */
@@ -64,9 +83,10 @@ void dt_collector_close(struct dt_collector* dt_col, struct nsd* nsd);
 /* start the collector process */
 void dt_collector_start(struct dt_collector* dt_col, struct nsd* nsd);
 
-/* submit auth query from worker.  It attempts to send it to the collector,
- * if the nonblocking fails, then it silently skips it.  So it does not block
- * on the log.
+/* submit auth query from worker.  It writes it in the ring for the
+ * collector, or attempts to send it to the collector, if the ring is full or
+ * the nonblocking send fails, then it silently skips it.  So it does not
+ * block on the log.
  */
 void dt_collector_submit_auth_query(struct nsd* nsd,
 #ifdef INET6
@@ -78,9 +98,10 @@ void dt_collector_submit_auth_query(struct nsd* nsd,
 #endif
 	socklen_t addrlen, int is_tcp, struct buffer* packet);
 
-/* submit auth response from worker.  It attempts to send it to the collector,
- * if the nonblocking fails, then it silently skips it.  So it does not block
- * on the log.
+/* submit auth response from worker.  It writes it in the ring for the
+ * collector, or attempts to send it to the collector, if the ring is full or
+ * the nonblocking send fails, then it silently skips it.  So it does not
+ * block on the log.
  */
 void dt_collector_submit_auth_response(struct nsd* nsd,
 #ifdef INET6
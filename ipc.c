@@ -267,9 +267,13 @@ stats_add(struct nsdst* total, struct nsdst* s)
 	total->raxfr += s->raxfr;
 	total->nona += s->nona;
 	total->rixfr += s->rixfr;
+	total->nsec3hash += s->nsec3hash;
+	total->nsec3cache += s->nsec3cache;
 
 	total->db_disk = s->db_disk;
 	total->db_mem = s->db_mem;
+	total->db_mem_unused = s->db_mem_unused;
+	total->db_mem_recycle = s->db_mem_recycle;
 }
 
 /** subtract stats from total */
@@ -301,6 +305,8 @@ stats_subtract(struct nsdst* total, struct nsdst* s)
 	total->raxfr -= s->raxfr;
 	total->nona -= s->nona;
 	total->rixfr -= s->rixfr;
+	total->nsec3hash -= s->nsec3hash;
+	total->nsec3cache -= s->nsec3cache;
 }
 #endif /* BIND8_STATS */
 
@@ -745,6 +751,7 @@ xfrd_handle_ipc_read(struct event* handler, xfrd_state_type* xfrd)
 			xfrd_set_reload_now(xfrd);
 		}
 		xfrd_prepare_zones_for_reload();
+		xfrd_clear_load_pending();
 		xfrd->reload_failed = 0;
 		break;
 	case NSD_PASS_TO_XFRD:
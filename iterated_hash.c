@@ -29,15 +29,22 @@ iterated_hash(unsigned char out[SHA_DIGEST_LENGTH],
 #if defined(HAVE_SHA1_INIT) && !defined(DEPRECATED_SHA1_INIT)
 	SHA_CTX ctx;
 #else
-	EVP_MD_CTX* ctx;
+	/* the digest context is kept between calls, the zone precompile
+	 * hashes every name in the zone and creating the context for every
+	 * name is a noticeable part of the time spent */
+	static EVP_MD_CTX* ctx = NULL;
+	static const EVP_MD* md = NULL;
 #endif
 	int n;
 #if defined(HAVE_SHA1_INIT) && !defined(DEPRECATED_SHA1_INIT)
 #else
-	ctx = EVP_MD_CTX_create();
 	if(!ctx) {
-		log_msg(LOG_ERR, "out of memory in iterated_hash");
-		return 0;
+		ctx = EVP_MD_CTX_create();
+		if(!ctx) {
+			log_msg(LOG_ERR, "out of memory in iterated_hash");
+			return 0;
+		}
+		md = EVP_sha1();
 	}
 #endif
 	assert(in && inlength > 0 && iterations >= 0);
@@ -50,8 +57,8 @@ iterated_hash(unsigned char out[SHA_DIGEST_LENGTH],
 			SHA1_Update(&ctx, salt, saltlength);
 		SHA1_Final(out, &ctx);
 #else
-		if(!EVP_DigestInit(ctx, EVP_sha1()))
-			log_msg(LOG_ERR, "iterated_hash could not EVP_DigestInit");
+		if(!EVP_DigestInit_ex(ctx, md, NULL))
+			log_msg(LOG_ERR, "iterated_hash could not EVP_DigestInit_ex");
 
 		if(!EVP_DigestUpdate(ctx, in, inlength))
 			log_msg(LOG_ERR, "iterated_hash could not EVP_DigestUpdate");
@@ -65,10 +72,6 @@ iterated_hash(unsigned char out[SHA_DIGEST_LENGTH],
 		in=out;
 		inlength=SHA_DIGEST_LENGTH;
 	}
-#if defined(HAVE_SHA1_INIT) && !defined(DEPRECATED_SHA1_INIT)
-#else
-	EVP_MD_CTX_destroy(ctx);
-#endif
 	return SHA_DIGEST_LENGTH;
 #else
 	(void)out; (void)salt; (void)saltlength;
@@ -19,6 +19,10 @@
 #  include <sys/stat.h>
 #endif
 #include <unistd.h>
+#include <fcntl.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include "ixfr.h"
 #include "packet.h"
@@ -27,6 +31,7 @@
 #include "options.h"
 #include "zonec.h"
 #include "zone.h"
+#include "lookup3.h"
 
 /*
  * For optimal compression IXFR response packets are limited in size
@@ -34,12 +39,15 @@
  */
 #define IXFR_MAX_MESSAGE_LEN MAX_COMPRESSION_OFFSET
 
-/* draft-ietf-dnsop-rfc2845bis-06, section 5.3.1 says to sign every packet */
-#define IXFR_TSIG_SIGN_EVERY_NTH	0	/* tsig sign every N packets. */
-
 /* initial space in rrs data for storing records */
 #define IXFR_STORE_INITIAL_SIZE 4096
 
+/* the binary ixfr file format starts with this string */
+#define IXFR_BINARY_MAGIC "NSDIXFB1"
+#define IXFR_BINARY_MAGIC_LEN 8
+/* number of RR sections in the binary file: newsoa, oldsoa, del, add */
+#define IXFR_BINARY_SECTIONS 4
+
 /* store compression for one name */
 struct rrcompress_entry {
 	/* rbtree node, key is this struct */
@@ -916,15 +924,8 @@ query_state_type query_ixfr(struct nsd *nsd, struct query *query)
 	}
 
 	/* check if it needs tsig signatures */
-	if(query->tsig.status == TSIG_OK) {
-#if IXFR_TSIG_SIGN_EVERY_NTH > 0
-		if(query->tsig.updates_since_last_prepare >= IXFR_TSIG_SIGN_EVERY_NTH) {
-#endif
-			query->tsig_sign_it = 1;
-#if IXFR_TSIG_SIGN_EVERY_NTH > 0
-		}
-#endif
-	}
+	if(query->tsig.status == TSIG_OK && xfr_tsig_batch_full(nsd, query))
+		query->tsig_sign_it = 1;
 	pktcompression_freeup(&pcomp);
 	return QUERY_IN_IXFR;
 }
@@ -1755,6 +1756,183 @@ static int ixfr_unlink_it_temp(const char* zname, const char* zfile,
 	return ixfr_unlink_it_ctmp(zname, zfile, file_num, silent_enoent, 1);
 }
 
+/*
+ * The binary ixfr file has, in network byte order:
+ * the magic string, u32 oldserial, u32 newserial, u32 data_size,
+ * u16 length and the zone name string, u16 length and the log string,
+ * for newsoa, oldsoa, del and add: u32 length and the uncompressed
+ * wireformat RRs, and a u32 checksum of the preceding contents.
+ */
+struct ixfr_binary {
+	uint32_t oldserial, newserial, data_size;
+	const char* zname;
+	uint16_t zname_len;
+	const char* log_str;
+	uint16_t log_len;
+	const uint8_t* rrs[IXFR_BINARY_SECTIONS];
+	uint32_t rrs_len[IXFR_BINARY_SECTIONS];
+};
+
+/* see if the ixfr file is in the binary format */
+static int ixfr_file_is_binary(const char* ixfrfile)
+{
+	char buf[IXFR_BINARY_MAGIC_LEN];
+	FILE* in = fopen(ixfrfile, "r");
+	int binary;
+	if(!in)
+		return 0;
+	binary = (fread(buf, 1, sizeof(buf), in) == sizeof(buf) &&
+		memcmp(buf, IXFR_BINARY_MAGIC, IXFR_BINARY_MAGIC_LEN) == 0);
+	fclose(in);
+	return binary;
+}
+
+/* map the binary ixfr file into memory, returns NULL on failure */
+static uint8_t* ixfr_binary_map(const char* ixfrfile, size_t* len)
+{
+	struct stat statbuf;
+	uint8_t* buf;
+	int fd = open(ixfrfile, O_RDONLY);
+	if(fd == -1) {
+		log_msg(LOG_ERR, "could not open %s: %s", ixfrfile,
+			strerror(errno));
+		return NULL;
+	}
+	if(fstat(fd, &statbuf) == -1 || statbuf.st_size == 0) {
+		log_msg(LOG_ERR, "could not stat %s: %s", ixfrfile,
+			(statbuf.st_size==0?"empty file":strerror(errno)));
+		close(fd);
+		return NULL;
+	}
+	*len = (size_t)statbuf.st_size;
+#ifdef HAVE_MMAP
+	buf = mmap(NULL, *len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(buf == MAP_FAILED) {
+		log_msg(LOG_ERR, "could not mmap %s: %s", ixfrfile,
+			strerror(errno));
+		close(fd);
+		return NULL;
+	}
+#else
+	buf = xalloc(*len);
+	if(read(fd, buf, *len) != (ssize_t)*len) {
+		log_msg(LOG_ERR, "could not read %s: %s", ixfrfile,
+			strerror(errno));
+		free(buf);
+		close(fd);
+		return NULL;
+	}
+#endif
+	close(fd);
+	return buf;
+}
+
+static void ixfr_binary_unmap(uint8_t* buf, size_t len)
+{
+#ifdef HAVE_MMAP
+	munmap(buf, len);
+#else
+	(void)len;
+	free(buf);
+#endif
+}
+
+/* see if the RRs in a binary section are well formed, with count the
+ * number of RRs */
+static int ixfr_binary_check_rrs(const uint8_t* rrs, size_t len,
+	size_t* count)
+{
+	size_t current = 0;
+	*count = 0;
+	while(current < len) {
+		size_t rrlen = count_rr_length(rrs, len, current);
+		if(rrlen == 0)
+			return 0;
+		current += rrlen;
+		(*count)++;
+	}
+	return 1;
+}
+
+/* parse and check the binary ixfr file contents */
+static int ixfr_binary_parse(const char* ixfrfile, const uint8_t* buf,
+	size_t len, struct ixfr_binary* b)
+{
+	size_t pos = IXFR_BINARY_MAGIC_LEN, count;
+	int i;
+	if(len < IXFR_BINARY_MAGIC_LEN + 12 + 4 + 4*IXFR_BINARY_SECTIONS + 4
+		|| memcmp(buf, IXFR_BINARY_MAGIC, IXFR_BINARY_MAGIC_LEN) != 0) {
+		log_msg(LOG_ERR, "file %s is too short", ixfrfile);
+		return 0;
+	}
+	if(hashlittle(buf, len-4, 0) != read_uint32(buf+len-4)) {
+		log_msg(LOG_ERR, "file %s has a checksum failure", ixfrfile);
+		return 0;
+	}
+	len -= 4;
+	b->oldserial = read_uint32(buf+pos);
+	b->newserial = read_uint32(buf+pos+4);
+	b->data_size = read_uint32(buf+pos+8);
+	pos += 12;
+	b->zname_len = read_uint16(buf+pos);
+	b->zname = (const char*)buf+pos+2;
+	pos += 2 + (size_t)b->zname_len;
+	if(pos+2 > len)
+		goto malformed;
+	b->log_len = read_uint16(buf+pos);
+	b->log_str = (const char*)buf+pos+2;
+	pos += 2 + (size_t)b->log_len;
+	for(i=0; i<IXFR_BINARY_SECTIONS; i++) {
+		if(pos+4 > len)
+			goto malformed;
+		b->rrs_len[i] = read_uint32(buf+pos);
+		b->rrs[i] = buf+pos+4;
+		pos += 4;
+		if(pos + (size_t)b->rrs_len[i] > len ||
+			!ixfr_binary_check_rrs(b->rrs[i], b->rrs_len[i],
+			&count))
+			goto malformed;
+		/* the newsoa and oldsoa sections have one RR */
+		if(i < 2 && count != 1)
+			goto malformed;
+		pos += (size_t)b->rrs_len[i];
+	}
+	if(pos != len)
+		goto malformed;
+	return 1;
+malformed:
+	log_msg(LOG_ERR, "file %s is malformed", ixfrfile);
+	return 0;
+}
+
+/* read the header of a binary ixfr file */
+static int ixfr_read_file_header_binary(const char* zname,
+	const char* ixfrfile, uint32_t* oldserial, uint32_t* newserial,
+	size_t* data_size)
+{
+	struct ixfr_binary b;
+	size_t len = 0;
+	uint8_t* buf = ixfr_binary_map(ixfrfile, &len);
+	if(!buf)
+		return 0;
+	if(!ixfr_binary_parse(ixfrfile, buf, len, &b)) {
+		ixfr_binary_unmap(buf, len);
+		return 0;
+	}
+	if(strlen(zname) != b.zname_len ||
+		strncmp(zname, b.zname, b.zname_len) != 0) {
+		log_msg(LOG_ERR, "file has wrong zone, expected zone %s, but found %.*s in file %s",
+			zname, (int)b.zname_len, b.zname, ixfrfile);
+		ixfr_binary_unmap(buf, len);
+		return 0;
+	}
+	*oldserial = b.oldserial;
+	*newserial = b.newserial;
+	*data_size = (size_t)b.data_size;
+	ixfr_binary_unmap(buf, len);
+	return 1;
+}
+
 /* read ixfr file header */
 int ixfr_read_file_header(const char* zname, const char* zfile,
 	int file_num, uint32_t* oldserial, uint32_t* newserial,
@@ -1765,6 +1943,9 @@ int ixfr_read_file_header(const char* zname, const char* zfile,
 	FILE* in;
 	int num_lines = 0, got_old = 0, got_new = 0, got_datasize = 0;
 	make_ixfr_name(ixfrfile, sizeof(ixfrfile), zfile, file_num);
+	if(ixfr_file_is_binary(ixfrfile))
+		return ixfr_read_file_header_binary(zname, ixfrfile, oldserial,
+			newserial, data_size);
 	in = fopen(ixfrfile, "r");
 	if(!in) {
 		if((errno == ENOENT && enoent_is_err) || (errno != ENOENT))
@@ -2152,6 +2333,60 @@ static int ixfr_write_file_data(struct zone* zone, struct ixfr_data* data,
 	return 1;
 }
 
+/* write the ixfr data file in the binary format */
+static int ixfr_write_file_binary(struct zone* zone, struct ixfr_data* data,
+	FILE* out, char* fname)
+{
+	const uint8_t* rrs[IXFR_BINARY_SECTIONS];
+	size_t rrs_len[IXFR_BINARY_SECTIONS];
+	size_t zname_len = strlen(zone->opts->name), log_len = 0, len, pos;
+	uint8_t* buf;
+	int i;
+	if(data->log_str)
+		log_len = strlen(data->log_str);
+	if(log_len > 0xffff)
+		log_len = 0xffff;
+	rrs[0] = data->newsoa; rrs_len[0] = data->newsoa_len;
+	rrs[1] = data->oldsoa; rrs_len[1] = data->oldsoa_len;
+	rrs[2] = data->del; rrs_len[2] = data->del_len;
+	rrs[3] = data->add; rrs_len[3] = data->add_len;
+	len = IXFR_BINARY_MAGIC_LEN + 12 + 2 + zname_len + 2 + log_len + 4;
+	for(i=0; i<IXFR_BINARY_SECTIONS; i++)
+		len += 4 + rrs_len[i];
+
+	/* compose it in memory for the checksum, and write it at once */
+	buf = xalloc(len);
+	memcpy(buf, IXFR_BINARY_MAGIC, IXFR_BINARY_MAGIC_LEN);
+	pos = IXFR_BINARY_MAGIC_LEN;
+	write_uint32(buf+pos, data->oldserial);
+	write_uint32(buf+pos+4, data->newserial);
+	write_uint32(buf+pos+8, (uint32_t)ixfr_data_size(data));
+	pos += 12;
+	write_uint16(buf+pos, (uint16_t)zname_len);
+	memcpy(buf+pos+2, zone->opts->name, zname_len);
+	pos += 2 + zname_len;
+	write_uint16(buf+pos, (uint16_t)log_len);
+	if(log_len)
+		memcpy(buf+pos+2, data->log_str, log_len);
+	pos += 2 + log_len;
+	for(i=0; i<IXFR_BINARY_SECTIONS; i++) {
+		write_uint32(buf+pos, (uint32_t)rrs_len[i]);
+		if(rrs_len[i])
+			memcpy(buf+pos+4, rrs[i], rrs_len[i]);
+		pos += 4 + rrs_len[i];
+	}
+	write_uint32(buf+pos, hashlittle(buf, pos, 0));
+
+	if(fwrite(buf, 1, len, out) != len || fflush(out) != 0) {
+		log_msg(LOG_ERR, "failed to write zone %s IXFR data %s: %s",
+			zone->opts->name, fname, strerror(errno));
+		free(buf);
+		return 0;
+	}
+	free(buf);
+	return 1;
+}
+
 int ixfr_write_file(struct zone* zone, struct ixfr_data* data,
 	const char* zfile, int file_num)
 {
@@ -2167,6 +2402,15 @@ int ixfr_write_file(struct zone* zone, struct ixfr_data* data,
 		return 0;
 	}
 
+	if(zone->opts->pattern && zone->opts->pattern->ixfr_binary) {
+		if(!ixfr_write_file_binary(zone, data, out, ixfrfile)) {
+			fclose(out);
+			return 0;
+		}
+		fclose(out);
+		data->file_num = file_num;
+		return 1;
+	}
 	if(!ixfr_write_file_header(zone, data, out)) {
 		log_msg(LOG_ERR, "could not write file header for zone %s IXFR file %s: %s",
 			zone->opts->name, ixfrfile, strerror(errno));
@@ -2239,6 +2483,23 @@ void ixfr_write_to_file(struct zone* zone, const char* zfile)
 	ixfr_write_files(zone, zfile);
 }
 
+int ixfr_rewrite_files(struct zone* zone, const char* zfile)
+{
+	struct ixfr_data* data;
+	int num = 0;
+	if(!zone->ixfr || !zone->ixfr->data)
+		return 0;
+	for(data = ixfr_data_first(zone->ixfr); data;
+		data = ixfr_data_next(zone->ixfr, data)) {
+		if(data->file_num == 0)
+			continue;
+		if(!ixfr_write_file(zone, data, zfile, data->file_num))
+			return -1;
+		num++;
+	}
+	return num;
+}
+
 /* delete from domain table */
 static void domain_table_delete(struct domain_table* table,
 	struct domain* domain)
@@ -2598,22 +2859,12 @@ static void ixfr_data_log(
 	log_msg(priority, "%s", message);
 }
 
-/* read ixfr data from file */
-static int ixfr_data_read(struct nsd* nsd, struct zone* zone,
+/* read ixfr data from a file in zone format, returns NULL on failure */
+static struct ixfr_data* ixfr_data_read_text(struct zone* zone,
 	const char* ixfrfile, uint32_t* dest_serial, int file_num)
 {
 	struct ixfr_data_state state = { 0 };
 
-	if(!zone->apex) {
-		return 0;
-	}
-	if(zone->ixfr &&
-		zone->ixfr->data->count == zone->opts->pattern->ixfr_number) {
-		VERBOSITY(3, (LOG_INFO, "zone %s skip %s IXFR data because only %d ixfr-number configured",
-			zone->opts->name, ixfrfile, (int)zone->opts->pattern->ixfr_number));
-		return 0;
-	}
-
 	/* the file has header comments, new soa, old soa, delsection,
 	 * addsection. The delsection and addsection end in a SOA of oldver
 	 * and newver respectively. */
@@ -2628,12 +2879,6 @@ static int ixfr_data_read(struct nsd* nsd, struct zone* zone,
 	state.stayregion = region_create(xalloc, free);
 	state.temptable = domain_table_create(state.stayregion);
 	state.tempzone = region_alloc_zero(state.stayregion, sizeof(*state.tempzone));
-	if(!zone->apex) {
-		ixfr_data_free(state.data);
-		region_destroy(state.tempregion);
-		region_destroy(state.stayregion);
-		return 0;
-	}
 	state.tempzone->apex = domain_table_insert(state.temptable,
 		domain_dname(zone->apex));
 	state.temptable->root->usage++;
@@ -2665,26 +2910,114 @@ static int ixfr_data_read(struct nsd* nsd, struct zone* zone,
 			ixfr_data_free(state.data);
 			region_destroy(state.tempregion);
 			region_destroy(state.stayregion);
-			return 0;
+			return NULL;
 		}
 	}
 
 	region_destroy(state.tempregion);
 	region_destroy(state.stayregion);
+	return state.data;
+}
+
+/* copy RRs from the mapped file into an allocated buffer */
+static uint8_t* ixfr_binary_copy(const uint8_t* rrs, uint32_t len)
+{
+	uint8_t* copy;
+	if(len == 0)
+		return NULL;
+	copy = xalloc(len);
+	memcpy(copy, rrs, len);
+	return copy;
+}
+
+/* read ixfr data from a file in the binary format, returns NULL on
+ * failure. The RRs are stored in wireformat, and are copied as is. */
+static struct ixfr_data* ixfr_data_read_binary(struct zone* zone,
+	const char* ixfrfile, uint32_t* dest_serial, int file_num)
+{
+	struct ixfr_binary b;
+	struct ixfr_data* data;
+	size_t len = 0;
+	uint8_t* buf = ixfr_binary_map(ixfrfile, &len);
+	if(!buf)
+		return NULL;
+	if(!ixfr_binary_parse(ixfrfile, buf, len, &b)) {
+		ixfr_binary_unmap(buf, len);
+		return NULL;
+	}
+	if(strlen(zone->opts->name) != b.zname_len ||
+		strncmp(zone->opts->name, b.zname, b.zname_len) != 0) {
+		log_msg(LOG_ERR, "zone %s ixfr data: file %s has wrong zone %.*s",
+			zone->opts->name, ixfrfile, (int)b.zname_len, b.zname);
+		ixfr_binary_unmap(buf, len);
+		return NULL;
+	}
+	if(b.newserial != *dest_serial) {
+		log_msg(LOG_ERR, "zone %s ixfr data: IXFR data contains the wrong version, serial %u but want destination serial %u",
+			zone->opts->name, (unsigned)b.newserial,
+			(unsigned)*dest_serial);
+		ixfr_binary_unmap(buf, len);
+		return NULL;
+	}
+	data = xalloc_zero(sizeof(*data));
+	data->file_num = file_num;
+	data->oldserial = b.oldserial;
+	data->newserial = b.newserial;
+	data->newsoa = ixfr_binary_copy(b.rrs[0], b.rrs_len[0]);
+	data->newsoa_len = b.rrs_len[0];
+	data->oldsoa = ixfr_binary_copy(b.rrs[1], b.rrs_len[1]);
+	data->oldsoa_len = b.rrs_len[1];
+	data->del = ixfr_binary_copy(b.rrs[2], b.rrs_len[2]);
+	data->del_len = b.rrs_len[2];
+	data->add = ixfr_binary_copy(b.rrs[3], b.rrs_len[3]);
+	data->add_len = b.rrs_len[3];
+	if(b.log_len != 0) {
+		data->log_str = xalloc(b.log_len+1);
+		memcpy(data->log_str, b.log_str, b.log_len);
+		data->log_str[b.log_len] = 0;
+	}
+	ixfr_binary_unmap(buf, len);
+	*dest_serial = data->oldserial;
+	return data;
+}
+
+/* read ixfr data from file */
+static int ixfr_data_read(struct nsd* nsd, struct zone* zone,
+	const char* ixfrfile, uint32_t* dest_serial, int file_num)
+{
+	struct ixfr_data* data;
+
+	if(!zone->apex) {
+		return 0;
+	}
+	if(zone->ixfr &&
+		zone->ixfr->data->count == zone->opts->pattern->ixfr_number) {
+		VERBOSITY(3, (LOG_INFO, "zone %s skip %s IXFR data because only %d ixfr-number configured",
+			zone->opts->name, ixfrfile, (int)zone->opts->pattern->ixfr_number));
+		return 0;
+	}
+
+	if(ixfr_file_is_binary(ixfrfile))
+		data = ixfr_data_read_binary(zone, ixfrfile, dest_serial,
+			file_num);
+	else	data = ixfr_data_read_text(zone, ixfrfile, dest_serial,
+			file_num);
+	if(!data)
+		return 0;
 
 	if(!zone->ixfr)
 		zone->ixfr = zone_ixfr_create(nsd);
 	if(zone->opts->pattern->ixfr_size != 0 &&
-		zone->ixfr->total_size + ixfr_data_size(state.data) >
+		zone->ixfr->total_size + ixfr_data_size(data) >
 		zone->opts->pattern->ixfr_size) {
 		VERBOSITY(3, (LOG_INFO, "zone %s skip %s IXFR data because only ixfr-size: %u configured, and it is %u size",
-			zone->opts->name, ixfrfile, (unsigned)zone->opts->pattern->ixfr_size, (unsigned)ixfr_data_size(state.data)));
-		ixfr_data_free(state.data);
+			zone->opts->name, ixfrfile, (unsigned)zone->opts->pattern->ixfr_size, (unsigned)ixfr_data_size(data)));
+		ixfr_data_free(data);
 		return 0;
 	}
-	zone_ixfr_add(zone->ixfr, state.data, 0);
+	zone_ixfr_add(zone->ixfr, data, 0);
 	VERBOSITY(3, (LOG_INFO, "zone %s read %s IXFR data of %u bytes",
-		zone->opts->name, ixfrfile, (unsigned)ixfr_data_size(state.data)));
+		zone->opts->name, ixfrfile, (unsigned)ixfr_data_size(data)));
 	return 1;
 }
 
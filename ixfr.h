@@ -236,6 +236,10 @@ void ixfr_write_to_file(struct zone* zone, const char* zfile);
 /* read ixfr contents from file for the zone */
 void ixfr_read_from_file(struct nsd* nsd, struct zone* zone, const char* zfile);
 
+/* write the ixfr contents that were read from file again, in the format
+ * that is configured for the zone. Returns number of files or -1 on error */
+int ixfr_rewrite_files(struct zone* zone, const char* zfile);
+
 /* get the current serial from the zone */
 uint32_t zone_get_current_serial(struct zone* zone);
 
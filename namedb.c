@@ -20,6 +20,54 @@
 #include "namedb.h"
 #include "nsec3.h"
 
+/** free the numlist array, region cleanup for the domain table */
+static void
+numlist_cleanup(void* arg)
+{
+	domain_table_type* table = (domain_table_type*)arg;
+	free(table->numlist);
+	table->numlist = NULL;
+	table->numlist_size = 0;
+}
+
+/* the first numlist array is allocated in the region, so the temporary
+ * domain tables with a few names need no malloc */
+#define NUMLIST_INITIAL_SIZE 16
+
+/** grow the numlist array, by a quarter once it is large, to limit the
+ * unused space for large zones; realloc can remap the pages of a large
+ * array */
+static void
+numlist_grow(domain_table_type* table)
+{
+	size_t newsize;
+	if(table->numlist_size < 1024)
+		newsize = (size_t)table->numlist_size*2;
+	else	newsize = (size_t)table->numlist_size
+			+ (size_t)table->numlist_size/4;
+	if(newsize > (size_t)UINT32_MAX)
+		newsize = (size_t)UINT32_MAX;
+	if(newsize <= (size_t)table->numlist_count+1) {
+		log_msg(LOG_ERR, "too many domain names");
+		exit(1);
+	}
+	if(table->numlist_size == NUMLIST_INITIAL_SIZE) {
+		/* move the array out of the region */
+		domain_type** numlist = (domain_type**)xalloc(
+			newsize*sizeof(domain_type*));
+		memcpy(numlist, table->numlist,
+			NUMLIST_INITIAL_SIZE*sizeof(domain_type*));
+		region_recycle(table->region, table->numlist,
+			NUMLIST_INITIAL_SIZE*sizeof(domain_type*));
+		table->numlist = numlist;
+		region_add_cleanup(table->region, numlist_cleanup, table);
+	} else {
+		table->numlist = (domain_type**)xrealloc(table->numlist,
+			newsize*sizeof(domain_type*));
+	}
+	table->numlist_size = (uint32_t)newsize;
+}
+
 static domain_type *
 allocate_domain_info(domain_table_type* table,
 		     const dname_type* dname,
@@ -49,13 +97,12 @@ allocate_domain_info(domain_table_type* table,
 #endif
 	result->is_existing = 0;
 	result->is_apex = 0;
-	assert(table->numlist_last); /* it exists because root exists */
+	assert(table->numlist_count); /* it exists because root exists */
 	/* push this domain at the end of the numlist */
-	result->number = table->numlist_last->number+1;
-	result->numlist_next = NULL;
-	result->numlist_prev = table->numlist_last;
-	table->numlist_last->numlist_next = result;
-	table->numlist_last = result;
+	if(table->numlist_count+1 >= table->numlist_size)
+		numlist_grow(table);
+	result->number = ++table->numlist_count;
+	table->numlist[result->number] = result;
 
 	return result;
 }
@@ -86,50 +133,23 @@ static void
 numlist_make_last(domain_table_type* table, domain_type* domain)
 {
 	uint32_t sw;
-	domain_type* last = table->numlist_last;
+	domain_type* last = domain_table_numlist_last(table);
 	if(domain == last)
 		return;
-	/* swap numbers with the last element */
+	/* swap numbers and list position with the last element */
 	sw = domain->number;
 	domain->number = last->number;
 	last->number = sw;
-	/* swap list position with the last element */
-	assert(domain->numlist_next);
-	assert(last->numlist_prev);
-	if(domain->numlist_next != last) {
-		/* case 1: there are nodes between domain .. last */
-		domain_type* span_start = domain->numlist_next;
-		domain_type* span_end = last->numlist_prev;
-		/* these assignments walk the new list from start to end */
-		if(domain->numlist_prev)
-			domain->numlist_prev->numlist_next = last;
-		last->numlist_prev = domain->numlist_prev;
-		last->numlist_next = span_start;
-		span_start->numlist_prev = last;
-		span_end->numlist_next = domain;
-		domain->numlist_prev = span_end;
-		domain->numlist_next = NULL;
-	} else {
-		/* case 2: domain and last are neighbors */
-		/* these assignments walk the new list from start to end */
-		if(domain->numlist_prev)
-			domain->numlist_prev->numlist_next = last;
-		last->numlist_prev = domain->numlist_prev;
-		last->numlist_next = domain;
-		domain->numlist_prev = last;
-		domain->numlist_next = NULL;
-	}
-	table->numlist_last = domain;
+	table->numlist[last->number] = last;
+	table->numlist[domain->number] = domain;
 }
 
 /** pop the biggest domain off the numlist */
 static domain_type*
 numlist_pop_last(domain_table_type* table)
 {
-	domain_type* d = table->numlist_last;
-	table->numlist_last = table->numlist_last->numlist_prev;
-	if(table->numlist_last)
-		table->numlist_last->numlist_next = NULL;
+	domain_type* d = domain_table_numlist_last(table);
+	table->numlist[table->numlist_count--] = NULL;
 	return d;
 }
 
@@ -334,8 +354,6 @@ domain_table_create(region_type* region)
 	root->usage = 1; /* do not delete root, ever */
 	root->is_existing = 0;
 	root->is_apex = 0;
-	root->numlist_prev = NULL;
-	root->numlist_next = NULL;
 #ifdef NSEC3
 	root->nsec3 = NULL;
 #endif
@@ -354,7 +372,11 @@ domain_table_create(region_type* region)
 #endif
 
 	result->root = root;
-	result->numlist_last = root;
+	result->numlist = (domain_type**)region_alloc_array(region,
+		NUMLIST_INITIAL_SIZE, sizeof(domain_type*));
+	result->numlist_count = 1;
+	result->numlist_size = NUMLIST_INITIAL_SIZE;
+	result->numlist[1] = root;
 #ifdef NSEC3
 	result->prehash_list = NULL;
 #endif
@@ -362,6 +384,29 @@ domain_table_create(region_type* region)
 	return result;
 }
 
+/* find the closest encloser from the closest match of dname */
+static void
+domain_table_closest_encloser(const dname_type *dname, int exact,
+	domain_type **closest_match, domain_type **closest_encloser)
+{
+	uint8_t label_match_count;
+
+	assert(*closest_match);
+
+	*closest_encloser = *closest_match;
+
+	if (!exact) {
+		label_match_count = dname_label_match_count(
+			domain_dname(*closest_encloser),
+			dname);
+		assert(label_match_count < dname->label_count);
+		while (label_match_count < domain_dname(*closest_encloser)->label_count) {
+			(*closest_encloser) = (*closest_encloser)->parent;
+			assert(*closest_encloser);
+		}
+	}
+}
+
 int
 domain_table_search(domain_table_type *table,
 		   const dname_type   *dname,
@@ -369,7 +414,6 @@ domain_table_search(domain_table_type *table,
 		   domain_type       **closest_encloser)
 {
 	int exact;
-	uint8_t label_match_count;
 
 	assert(table);
 	assert(dname);
@@ -383,22 +427,40 @@ domain_table_search(domain_table_type *table,
 #else
 	exact = rbtree_find_less_equal(table->names_to_domains, dname, (rbnode_type **) closest_match);
 #endif
-	assert(*closest_match);
+	domain_table_closest_encloser(dname, exact, closest_match,
+		closest_encloser);
+	return exact;
+}
 
-	*closest_encloser = *closest_match;
+int
+domain_table_search_key(domain_table_type *table,
+		   const dname_type   *dname,
+		   uint8_t            *key,
+		   size_t              keylen,
+		   domain_type       **closest_match,
+		   domain_type       **closest_encloser)
+{
+#ifdef USE_RADIX_TREE
+	int exact;
 
-	if (!exact) {
-		label_match_count = dname_label_match_count(
-			domain_dname(*closest_encloser),
-			dname);
-		assert(label_match_count < dname->label_count);
-		while (label_match_count < domain_dname(*closest_encloser)->label_count) {
-			(*closest_encloser) = (*closest_encloser)->parent;
-			assert(*closest_encloser);
-		}
-	}
+	assert(table);
+	assert(dname);
+	assert(key);
+	assert(closest_match);
+	assert(closest_encloser);
 
+	exact = radix_find_less_equal(table->nametree, key,
+		(radstrlen_type)keylen, (struct radnode**)closest_match);
+	*closest_match = (domain_type*)((*(struct radnode**)closest_match)->elem);
+	domain_table_closest_encloser(dname, exact, closest_match,
+		closest_encloser);
 	return exact;
+#else
+	(void)key;
+	(void)keylen;
+	return domain_table_search(table, dname, closest_match,
+		closest_encloser);
+#endif
 }
 
 domain_type *
@@ -697,6 +759,18 @@ namedb_lookup(struct namedb* db,
 		db->domains, dname, closest_match, closest_encloser);
 }
 
+int
+namedb_lookup_key(struct namedb* db,
+	      const dname_type* dname,
+	      uint8_t* key,
+	      size_t keylen,
+	      domain_type     **closest_match,
+	      domain_type     **closest_encloser)
+{
+	return domain_table_search_key(db->domains, dname, key, keylen,
+		closest_match, closest_encloser);
+}
+
 void zone_rr_iter_init(struct zone_rr_iter *iter, struct zone *zone)
 {
 	assert(iter != NULL);
@@ -44,9 +44,12 @@ struct domain_table
 	rbtree_type      *names_to_domains;
 #endif
 	domain_type* root;
-	/* ptr to biggest domain.number and last in list.
-	 * the root is the lowest and first in the list. */
-	domain_type *numlist_last;
+	/* the domains by domain.number, numlist[number] is the domain.
+	 * the root is number 1, element 0 is not used. The numbers are
+	 * 1 .. numlist_count, numlist_size is the allocated size. */
+	domain_type **numlist;
+	uint32_t numlist_count;
+	uint32_t numlist_size;
 #ifdef NSEC3
 	/* the prehash list, start of the list */
 	domain_type* prehash_list;
@@ -107,9 +110,7 @@ struct domain
 #ifdef NSEC3
 	struct nsec3_domain_data* nsec3;
 #endif
-	/* double-linked list sorted by domain.number */
-	domain_type* numlist_prev, *numlist_next;
-	uint32_t     number; /* Unique domain name number.  */
+	uint32_t     number; /* Unique domain name number, index in numlist */
 	uint32_t     usage; /* number of ptrs to this from RRs(in rdata) and
 			     from zone-apex pointers, also the root has one
 			     more to make sure it cannot be deleted. */
@@ -142,6 +143,7 @@ struct zone
 	char*        filename; /* set if read from file, which file */
 	char*        logstr; /* set for zone xfer, the log string */
 	struct timespec mtime; /* time of last modification */
+	pid_t        writer_pid; /* background zonefile writer, or 0 */
 	unsigned     zonestatid; /* array index for zone stats */
 	unsigned     is_secure : 1; /* zone uses DNSSEC */
 	unsigned     is_ok : 1; /* zone has not expired */
@@ -150,6 +152,8 @@ struct zone
 	unsigned     is_skipped : 1; /* subsequent zone updates are skipped */
 	unsigned     is_checked : 1; /* zone already verified */
 	unsigned     is_bad : 1; /* zone failed verification */
+	unsigned     is_load_tried : 1; /* zonefile read was attempted */
+	unsigned     is_write_queued : 1; /* for the background writer */
 } ATTR_PACKED;
 
 /* a RR in DNS */
@@ -188,6 +192,13 @@ union rdata_atom
 	uint16_t*    data;
 };
 
+/* the domain with the biggest domain.number */
+static inline domain_type *
+domain_table_numlist_last(domain_table_type *table)
+{
+	return table->numlist[table->numlist_count];
+}
+
 /*
  * Create a new domain_table containing only the root domain.
  */
@@ -201,6 +212,17 @@ int domain_table_search(domain_table_type* table,
 			domain_type      **closest_match,
 			domain_type      **closest_encloser);
 
+/*
+ * Search the domain table like domain_table_search, with the radix tree
+ * key of dname already made, see dname_make_in_buffer.
+ */
+int domain_table_search_key(domain_table_type* table,
+			const dname_type* dname,
+			uint8_t* key,
+			size_t keylen,
+			domain_type      **closest_match,
+			domain_type      **closest_encloser);
+
 /*
  * The number of domains stored in the table (minimum is one for the
  * root domain).
@@ -338,6 +360,8 @@ struct namedb
 	/* if diff_skip=1, diff_pos contains the nsd.diff place to continue */
 	uint8_t		  diff_skip;
 	off_t		  diff_pos;
+	/* number of processes that hash names for the NSEC3 precompile */
+	int		  nsec3_workers;
 };
 
 static inline int rdata_atom_is_domain(uint16_t type, size_t index);
@@ -381,6 +405,12 @@ int namedb_lookup (struct namedb* db,
 		   const dname_type* dname,
 		   domain_type     **closest_match,
 		   domain_type     **closest_encloser);
+int namedb_lookup_key(struct namedb* db,
+		   const dname_type* dname,
+		   uint8_t* key,
+		   size_t keylen,
+		   domain_type     **closest_match,
+		   domain_type     **closest_encloser);
 /* pass number of children (to alloc in dirty array */
 struct namedb *namedb_open(struct nsd_options* opt);
 void namedb_close(struct namedb* db);
@@ -403,6 +433,13 @@ namedb_find_or_create_zone(namedb_type *db, const dname_type *dname,
 void namedb_zone_delete(namedb_type* db, zone_type* zone);
 void namedb_write_zonefile(struct nsd* nsd, struct zone_options* zopt);
 void namedb_write_zonefiles(struct nsd* nsd, struct nsd_options* options);
+/** fork the background writer for the queued zonefiles, in the reload
+ * when the SIGCHLD of the writer is no longer ignored */
+void namedb_write_zonefiles_start(struct nsd* nsd);
+/** the child process has exited, if it is a background zonefile writer,
+ * its zones are marked as changed again when it failed. Returns false if
+ * the process is not a zonefile writer */
+int namedb_zonefile_writer_exited(struct nsd* nsd, pid_t pid, int status);
 int create_dirs(const char* path);
 int file_get_mtime(const char* file, struct timespec* mtime, int* nonexist);
 void allocate_domain_nsec3(domain_table_type *table, domain_type *result);
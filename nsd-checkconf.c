@@ -16,6 +16,7 @@
 #include "options.h"
 #include "util.h"
 #include "dname.h"
+#include "dns.h"
 #include "rrl.h"
 
 extern char *optarg;
@@ -355,9 +356,11 @@ config_print_zone(nsd_options_type* opt, const char* k, int s, const char *o,
 		ZONE_GET_RRL(rrl_whitelist, o, zone->pattern);
 #endif
 		ZONE_GET_BIN(multi_primary_check, o, zone->pattern);
+		ZONE_GET_BIN(probe_primaries, o, zone->pattern);
 		ZONE_GET_BIN(store_ixfr, o, zone->pattern);
 		ZONE_GET_INT(ixfr_size, o, zone->pattern);
 		ZONE_GET_INT(ixfr_number, o, zone->pattern);
+		ZONE_GET_BIN(ixfr_binary, o, zone->pattern);
 		ZONE_GET_BIN(create_ixfr, o, zone->pattern);
 		printf("Zone option not handled: %s %s\n", z, o);
 		exit(1);
@@ -392,9 +395,11 @@ config_print_zone(nsd_options_type* opt, const char* k, int s, const char *o,
 		ZONE_GET_RRL(rrl_whitelist, o, p);
 #endif
 		ZONE_GET_BIN(multi_primary_check, o, p);
+		ZONE_GET_BIN(probe_primaries, o, p);
 		ZONE_GET_BIN(store_ixfr, o, p);
 		ZONE_GET_INT(ixfr_size, o, p);
 		ZONE_GET_INT(ixfr_number, o, p);
+		ZONE_GET_BIN(ixfr_binary, o, p);
 		ZONE_GET_BIN(create_ixfr, o, p);
 		printf("Pattern option not handled: %s %s\n", pat, o);
 		exit(1);
@@ -413,6 +418,8 @@ config_print_zone(nsd_options_type* opt, const char* k, int s, const char *o,
 		SERV_GET_BIN(drop_updates, o);
 		SERV_GET_BIN(reload_config, o);
 		SERV_GET_BIN(zonefiles_check, o);
+		SERV_GET_BIN(zonefiles_write_background, o);
+		SERV_GET_BIN(zonefiles_lazy_load, o);
 		SERV_GET_BIN(log_time_ascii, o);
 		SERV_GET_BIN(round_robin, o);
 		SERV_GET_BIN(minimal_responses, o);
@@ -449,7 +456,16 @@ config_print_zone(nsd_options_type* opt, const char* k, int s, const char *o,
 		SERV_GET_INT(tcp_mss, o);
 		SERV_GET_INT(outgoing_tcp_mss, o);
 		SERV_GET_INT(xfrd_tcp_max, o);
+		SERV_GET_INT(nsec3_precompile_workers, o);
+		SERV_GET_INT(nsec3_hash_cache_size, o);
+		SERV_GET_BIN(db_huge_pages, o);
 		SERV_GET_INT(xfrd_tcp_pipeline, o);
+		SERV_GET_INT(xfrd_primary_rate_limit, o);
+		SERV_GET_BIN(xfrd_startup_spread, o);
+		SERV_GET_INT(xfrd_catalog_refresh_rate, o);
+		SERV_GET_INT(xfrd_notify_max, o);
+		SERV_GET_INT(xfrd_notify_rate_limit, o);
+		SERV_GET_INT(xfr_tsig_sign_every, o);
 		SERV_GET_INT(ipv4_edns_size, o);
 		SERV_GET_INT(ipv6_edns_size, o);
 		SERV_GET_INT(statistics, o);
@@ -480,6 +496,9 @@ config_print_zone(nsd_options_type* opt, const char* k, int s, const char *o,
 		SERV_GET_STR(dnstap_version, o);
 		SERV_GET_BIN(dnstap_log_auth_query_messages, o);
 		SERV_GET_BIN(dnstap_log_auth_response_messages, o);
+		SERV_GET_INT(dnstap_sample_rate, o);
+		SERV_GET_INT(dnstap_log_min_response_size, o);
+		SERV_GET_BIN(dnstap_log_truncated, o);
 #endif
 		SERV_GET_INT(zonefiles_write, o);
 		/* remote control */
@@ -527,6 +546,8 @@ static void print_zone_content_elems(pattern_options_type* pat)
 	print_acl("request-xfr:", pat->request_xfr);
 	if(pat->multi_primary_check)
 		printf("\tmulti-primary-check: %s\n", pat->multi_primary_check?"yes":"no");
+	if(pat->probe_primaries)
+		printf("\tprobe-primaries: %s\n", pat->probe_primaries?"yes":"no");
 	if(!pat->notify_retry_is_default)
 		printf("\tnotify-retry: %d\n", pat->notify_retry);
 	print_acl("notify:", pat->notify);
@@ -556,6 +577,8 @@ static void print_zone_content_elems(pattern_options_type* pat)
 		printf("\tstore-ixfr: %s\n", pat->store_ixfr?"yes":"no");
 	if(!pat->ixfr_number_is_default)
 		printf("\tixfr-number: %u\n", (unsigned)pat->ixfr_number);
+	if(pat->ixfr_binary)
+		printf("\tixfr-binary: %s\n", pat->ixfr_binary?"yes":"no");
 	if(!pat->ixfr_size_is_default)
 		printf("\tixfr-size: %u\n", (unsigned)pat->ixfr_size);
 	if(!pat->create_ixfr_is_default)
@@ -610,6 +633,9 @@ config_test_print_server(nsd_options_type* opt)
 	tls_auth_options_type* tlsauth;
 	zone_options_type* zone;
 	pattern_options_type* pat;
+#ifdef USE_DNSTAP
+	struct dnstap_filter_list* f;
+#endif
 
 	printf("# Config settings.\n");
 	printf("server:\n");
@@ -659,6 +685,15 @@ config_test_print_server(nsd_options_type* opt)
 	printf("\toutgoing-tcp-mss: %d\n", opt->outgoing_tcp_mss);
 	printf("\txfrd-tcp-max: %d\n", opt->xfrd_tcp_max);
 	printf("\txfrd-tcp-pipeline: %d\n", opt->xfrd_tcp_pipeline);
+	printf("\txfrd-primary-rate-limit: %d\n", opt->xfrd_primary_rate_limit);
+	printf("\txfrd-startup-spread: %s\n", opt->xfrd_startup_spread?"yes":"no");
+	printf("\txfrd-catalog-refresh-rate: %d\n", opt->xfrd_catalog_refresh_rate);
+	printf("\txfrd-notify-max: %d\n", opt->xfrd_notify_max);
+	printf("\txfrd-notify-rate-limit: %d\n", opt->xfrd_notify_rate_limit);
+	printf("\txfr-tsig-sign-every: %d\n", opt->xfr_tsig_sign_every);
+	printf("\tnsec3-precompile-workers: %d\n", opt->nsec3_precompile_workers);
+	printf("\tnsec3-hash-cache-size: %d\n", (int)opt->nsec3_hash_cache_size);
+	printf("\tdb-huge-pages: %s\n", opt->db_huge_pages?"yes":"no");
 	printf("\tipv4-edns-size: %d\n", (int) opt->ipv4_edns_size);
 	printf("\tipv6-edns-size: %d\n", (int) opt->ipv6_edns_size);
 	print_string_var("pidfile:", opt->pidfile);
@@ -710,6 +745,8 @@ config_test_print_server(nsd_options_type* opt)
 	printf("\treload-config: %s\n", opt->reload_config?"yes":"no");
 	printf("\tzonefiles-check: %s\n", opt->zonefiles_check?"yes":"no");
 	printf("\tzonefiles-write: %d\n", opt->zonefiles_write);
+	printf("\tzonefiles-write-background: %s\n", opt->zonefiles_write_background?"yes":"no");
+	printf("\tzonefiles-lazy-load: %s\n", opt->zonefiles_lazy_load?"yes":"no");
 	print_string_var("tls-service-key:", opt->tls_service_key);
 	print_string_var("tls-service-pem:", opt->tls_service_pem);
 	print_string_var("tls-service-ocsp:", opt->tls_service_ocsp);
@@ -742,6 +779,15 @@ config_test_print_server(nsd_options_type* opt)
 	print_string_var("dnstap-version:", opt->dnstap_version);
 	printf("\tdnstap-log-auth-query-messages: %s\n", opt->dnstap_log_auth_query_messages?"yes":"no");
 	printf("\tdnstap-log-auth-response-messages: %s\n", opt->dnstap_log_auth_response_messages?"yes":"no");
+	printf("\tdnstap-sample-rate: %d\n", opt->dnstap_sample_rate);
+	for(f = opt->dnstap_log_zones; f; f = f->next)
+		print_string_var("dnstap-log-zone:", dname_to_string(f->zone, NULL));
+	for(f = opt->dnstap_log_qtypes; f; f = f->next)
+		printf("\tdnstap-log-qtype: %s\n", rrtype_to_string(f->num));
+	for(f = opt->dnstap_log_rcodes; f; f = f->next)
+		printf("\tdnstap-log-rcode: %d\n", (int)f->num);
+	printf("\tdnstap-log-min-response-size: %d\n", opt->dnstap_log_min_response_size);
+	printf("\tdnstap-log-truncated: %s\n", opt->dnstap_log_truncated?"yes":"no");
 #endif
 
 	printf("\nremote-control:\n");
@@ -39,13 +39,34 @@ usage (void)
 	fprintf(stderr, "\t-i <old zone file>\tcreate an IXFR from the differences between the\n\t\told zone file and the new zone file. Writes to \n\t\t<zonefile>.ixfr and renames other <zonefile>.ixfr files to\n\t\t<zonefile>.ixfr.num+1.\n");
 	fprintf(stderr, "\t-n <ixfr number>\tnumber of IXFR versions to store, at most.\n\t\tdefault %d.\n", (int)IXFR_NUMBER_DEFAULT);
 	fprintf(stderr, "\t-s <ixfr size>\tsize of IXFR to store, at most. default %d.\n", (int)IXFR_SIZE_DEFAULT);
+	fprintf(stderr, "\t-c <text|binary>\tconvert the <zonefile>.ixfr files of the\n\t\tzone to zone format text or to the binary format.\n");
 	fprintf(stderr, "Version %s. Report bugs to <%s>.\n",
 		PACKAGE_VERSION, PACKAGE_BUGREPORT);
 }
 
+/* convert the ixfr files of the zone to the binary or text format */
+static void
+convert_ixfr(struct nsd* nsd, zone_type* zone, const char* fname, int binary)
+{
+	int num;
+	zone->opts->pattern = pattern_options_create(nsd->options->region);
+	/* read all the files there are */
+	zone->opts->pattern->ixfr_number = 0xffffffff;
+	zone->opts->pattern->ixfr_size = 0;
+	zone->opts->pattern->ixfr_binary = binary;
+	nsd->region = nsd->options->region;
+	ixfr_read_from_file(nsd, zone, fname);
+	num = ixfr_rewrite_files(zone, fname);
+	if(num == -1)
+		error("could not convert IXFR files");
+	printf("zone %s converted %d IXFR files of %s to %s\n",
+		zone->opts->name, num, fname, (binary?"binary":"text"));
+}
+
 static void
 check_zone(struct nsd* nsd, const char* name, const char* fname, FILE *out,
-	const char* oldzone, uint32_t ixfr_number, uint64_t ixfr_size)
+	const char* oldzone, uint32_t ixfr_number, uint64_t ixfr_size,
+	int convert)
 {
 	const dname_type* dname;
 	zone_options_type* zo;
@@ -103,6 +124,8 @@ check_zone(struct nsd* nsd, const char* name, const char* fname, FILE *out,
 		printf("zone %s created IXFR %s.ixfr\n", name, fname);
 		ixfr_create_free(ixfrcr);
 	}
+	if(convert != -1)
+		convert_ixfr(nsd, zone, fname, convert);
 	if (out) {
 		print_rrs(out, zone);
 		printf("; ");
@@ -139,14 +162,25 @@ main(int argc, char *argv[])
 	uint32_t ixfr_number = IXFR_NUMBER_DEFAULT;
 	uint64_t ixfr_size = IXFR_SIZE_DEFAULT;
 	char* oldzone = NULL;
+	int convert = -1;
 	struct nsd nsd;
 	memset(&nsd, 0, sizeof(nsd));
 
 	log_init("nsd-checkzone");
 
 	/* Parse the command line... */
-	while ((c = getopt(argc, argv, "hi:n:ps:")) != -1) {
+	while ((c = getopt(argc, argv, "c:hi:n:ps:")) != -1) {
 		switch (c) {
+		case 'c':
+			if(strcmp(optarg, "binary") == 0)
+				convert = 1;
+			else if(strcmp(optarg, "text") == 0)
+				convert = 0;
+			else {
+				usage();
+				exit(1);
+			}
+			break;
 		case 'h':
 			usage();
 			exit(0);
@@ -185,7 +219,7 @@ main(int argc, char *argv[])
 		verbosity = nsd.options->verbosity;
 
 	check_zone(&nsd, argv[0], argv[1], print_zone ? stdout : NULL,
-		oldzone, ixfr_number, ixfr_size);
+		oldzone, ixfr_number, ixfr_size, convert);
 	region_destroy(nsd.options->region);
 	/* yylex_destroy(); but, not available in all versions of flex */
 
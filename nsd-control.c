@@ -128,6 +128,7 @@ usage()
 	printf("  transfer [<zone>]		try to update secondary zones to newer serial\n");
 	printf("  force_transfer [<zone>]	update secondary zones with AXFR, no serial check\n");
 	printf("  zonestatus [<zone>]		print state, serial, activity\n");
+	printf("  xfrd_status			print zone transfer queues\n");
 	printf("  serverpid			get pid of server process\n");
 	printf("  verbosity <number>		change logging detail\n");
 	printf("  print_tsig [<key_name>]	print tsig with <name> the secret and algo\n");
@@ -30,6 +30,8 @@ struct netio_handler;
 struct nsd_options;
 struct udb_base;
 struct daemon_remote;
+struct nsec3_hash_cache;
+struct zonefile_writer;
 #ifdef USE_DNSTAP
 struct dt_collector;
 #endif
@@ -133,7 +135,11 @@ struct nsdst {
 	/* Dropped, truncated, queries for nonconfigured zone, tx errors */
 	stc_type dropped, truncated, wrongzone, txerr, rxerr;
 	stc_type edns, ednserr, raxfr, nona, rixfr;
+	/* NSEC3 hashes computed for queries, and found in the cache */
+	stc_type nsec3hash, nsec3cache;
 	uint64_t db_disk, db_mem;
+	/* unused space and recycle bin size of the database region */
+	uint64_t db_mem_unused, db_mem_recycle;
 };
 #endif /* BIND8_STATS */
 
@@ -212,6 +218,16 @@ struct cookie_secret {
 	uint8_t cookie_secret[NSD_COOKIE_SECRET_SIZE];
 };
 
+/* timings of the phases of applying transfers in the reload process */
+struct xfr_apply_stats {
+	/* number of transfers applied and number of zones prehashed */
+	size_t xfrs, zones;
+	/* time spent reading and applying the transfer contents */
+	struct timespec apply_time;
+	/* time spent in the NSEC3 prehash of the changed zones */
+	struct timespec prehash_time;
+};
+
 /* NSD configuration and run-time variables */
 typedef struct nsd nsd_type;
 struct	nsd
@@ -295,6 +311,17 @@ struct	nsd
 	int verifier_pipe[2]; /* Pipe to trigger verifier exit handler */
 	struct verifier *verifiers;
 
+	/* in the reload process, the zone that was updated by a transfer
+	 * and whose NSEC3 prehash is postponed, because consecutive
+	 * transfers for the same zone are prehashed once, after the last */
+	struct zone *prehash_pending;
+	/* in the reload process, the timings of the transfer phases */
+	struct xfr_apply_stats xfr_stats;
+	/* zones are queued for the background zonefile writer */
+	int zonefile_write_queued;
+	/* background zonefile writers that have not been reaped */
+	struct zonefile_writer* zonefile_writers;
+
 	edns_data_type edns_ipv4;
 #if defined(INET6)
 	edns_data_type edns_ipv6;
@@ -341,6 +368,11 @@ struct	nsd
 	/* start value for per process statistics printout, to clear it */
 	struct nsdst stat_proc;
 #endif /* BIND8_STATS */
+#ifdef NSEC3
+	/* in a server process, the cache of NSEC3 hashes of nonexistent
+	 * names, NULL if not in use */
+	struct nsec3_hash_cache* nsec3_hash_cache;
+#endif
 #ifdef USE_DNSTAP
 	/* the dnstap collector process info */
 	struct dt_collector* dt_collector;
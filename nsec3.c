@@ -10,6 +10,17 @@
 #ifdef NSEC3
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
+#define MAP_ANONYMOUS   MAP_ANON
+#endif
+#endif /* HAVE_MMAP */
 
 #include "nsec3.h"
 #include "iterated_hash.h"
@@ -17,6 +28,7 @@
 #include "nsd.h"
 #include "answer.h"
 #include "options.h"
+#include "lookup3.h"
 
 #define NSEC3_RDATA_BITMAP 5
 
@@ -599,6 +611,147 @@ nsec3_precompile_nsec3rr(namedb_type* db, struct domain* domain,
 	}
 }
 
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS)
+/* zones with fewer names to hash are hashed in the process itself,
+ * forking worker processes does not pay off for them */
+#define NSEC3_WORKERS_MIN_NAMES 10000
+
+/* if the names of the domain are hashed by the workers, the wildcard
+ * child name *.domain must fit in a domain name */
+static int
+nsec3_worker_hashable(domain_type* d, zone_type* zone)
+{
+	return (nsec3_condition_hash(d, zone) ||
+		nsec3_condition_dshash(d, zone)) &&
+		domain_dname(d)->name_size + 2 <= MAXDOMAINLEN;
+}
+
+/* hash the domain name and the wildcard child name, by a worker */
+static void
+nsec3_worker_hash(zone_type* zone, domain_type* d, uint8_t* store)
+{
+	const unsigned char* salt = NULL;
+	int saltlength = 0, iterations = 0;
+	const dname_type* dname = domain_dname(d);
+	uint8_t wc[MAXDOMAINLEN+2];
+
+	detect_nsec3_params(zone->nsec3_param, &salt, &saltlength,
+		&iterations);
+	iterated_hash(store, salt, saltlength, dname_name(dname),
+		dname->name_size, iterations);
+	wc[0] = 1;
+	wc[1] = '*';
+	memcpy(wc+2, dname_name(dname), dname->name_size);
+	iterated_hash(store+NSEC3_HASH_LEN, salt, saltlength, wc,
+		dname->name_size+2, iterations);
+}
+
+/*
+ * Hash the names of the zone in worker processes and store the hashes
+ * with the domains, so that the precompile does not have to hash them.
+ * The workers write the hashes in a shared mapping. Names that are not
+ * hashed by a worker, because it failed, are hashed by the precompile.
+ */
+static void
+nsec3_precompile_hash_workers(namedb_type* db, zone_type* zone)
+{
+	domain_type* walk, **list;
+	size_t num = 0, i, w, workers = (size_t)db->nsec3_workers;
+	size_t hashsize, mapsize;
+	uint8_t* map, *done;
+	pid_t* pids;
+
+	for(walk=zone->apex; walk && domain_is_subdomain(walk, zone->apex);
+		walk = domain_next(walk)) {
+		if(nsec3_worker_hashable(walk, zone))
+			num++;
+	}
+	if(num < NSEC3_WORKERS_MIN_NAMES)
+		return;
+	if(workers > num)
+		workers = num;
+	/* per name the hash and the wildcard child hash, and per worker
+	 * a flag that it has completed its part */
+	hashsize = num*NSEC3_HASH_LEN*2;
+	mapsize = hashsize + workers;
+	map = (uint8_t*)mmap(NULL, mapsize, PROT_READ|PROT_WRITE,
+		MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	if(map == MAP_FAILED) {
+		log_msg(LOG_ERR, "nsec3 precompile: could not mmap: %s",
+			strerror(errno));
+		return;
+	}
+	done = map + hashsize;
+	memset(done, 0, workers);
+	list = (domain_type**)xalloc_array_zero(num, sizeof(domain_type*));
+	pids = (pid_t*)xalloc_array_zero(workers, sizeof(pid_t));
+	i = 0;
+	for(walk=zone->apex; walk && domain_is_subdomain(walk, zone->apex);
+		walk = domain_next(walk)) {
+		if(nsec3_worker_hashable(walk, zone))
+			list[i++] = walk;
+	}
+
+	/* worker w hashes the part from num*w/workers to num*(w+1)/workers */
+	for(w=0; w<workers; w++) {
+		pids[w] = fork();
+		if(pids[w] == -1) {
+			log_msg(LOG_ERR, "nsec3 precompile: could not fork: %s",
+				strerror(errno));
+			break;
+		} else if(pids[w] == 0) {
+			for(i=num*w/workers; i<num*(w+1)/workers; i++)
+				nsec3_worker_hash(zone, list[i],
+					map+i*NSEC3_HASH_LEN*2);
+			done[w] = 1;
+			_exit(0);
+		}
+	}
+	for(i=0; i<workers && i<w; i++) {
+		while(waitpid(pids[i], NULL, 0) == -1 && errno == EINTR)
+			;
+	}
+
+	/* store the hashes of the completed parts with the domains */
+	for(w=0; w<workers; w++) {
+		if(!done[w])
+			continue;
+		for(i=num*w/workers; i<num*(w+1)/workers; i++) {
+			domain_type* d = list[i];
+			uint8_t* hash = map+i*NSEC3_HASH_LEN*2;
+			allocate_domain_nsec3(db->domains, d);
+			if(nsec3_condition_hash(d, zone) &&
+				!d->nsec3->hash_wc) {
+				d->nsec3->hash_wc = (nsec3_hash_wc_node_type*)
+					region_alloc(db->region,
+					sizeof(nsec3_hash_wc_node_type));
+				d->nsec3->hash_wc->hash.node.key = NULL;
+				d->nsec3->hash_wc->wc.node.key = NULL;
+				memmove(d->nsec3->hash_wc->hash.hash, hash,
+					NSEC3_HASH_LEN);
+				memmove(d->nsec3->hash_wc->wc.hash,
+					hash+NSEC3_HASH_LEN, NSEC3_HASH_LEN);
+			}
+			if(nsec3_condition_dshash(d, zone) &&
+				!d->nsec3->ds_parent_hash) {
+				d->nsec3->ds_parent_hash =
+					(nsec3_hash_node_type*)region_alloc(
+					db->region,
+					sizeof(nsec3_hash_node_type));
+				d->nsec3->ds_parent_hash->node.key = NULL;
+				memmove(d->nsec3->ds_parent_hash->hash, hash,
+					NSEC3_HASH_LEN);
+			}
+		}
+	}
+	VERBOSITY(2, (LOG_INFO, "nsec3 %s hashed %u names with %u workers",
+		zone->opts->name, (unsigned)num, (unsigned)workers));
+	free(pids);
+	free(list);
+	munmap(map, mapsize);
+}
+#endif /* HAVE_MMAP && MAP_ANONYMOUS */
+
 void
 nsec3_precompile_newparam(namedb_type* db, zone_type* zone)
 {
@@ -615,6 +768,11 @@ nsec3_precompile_newparam(namedb_type* db, zone_type* zone)
 			nsec3_precompile_nsec3rr(db, walk, zone);
 		}
 	}
+#if defined(HAVE_MMAP) && defined(MAP_ANONYMOUS)
+	/* for large zones, hash the names in parallel */
+	if(db->nsec3_workers > 1)
+		nsec3_precompile_hash_workers(db, zone);
+#endif
 	/* hash and precompile zone */
 	for(walk=zone->apex; walk && domain_is_subdomain(walk, zone->apex);
 		walk = domain_next(walk)) {
@@ -856,6 +1014,90 @@ void prehash_zone(struct namedb* db, struct zone* zone)
 	}
 }
 
+/* an entry in the cache of hashes of nonexistent names */
+struct nsec3_hash_cache_entry {
+	/* zone of the name, NULL if the entry is empty */
+	struct zone* zone;
+	/* the NSEC3 domain that covers (or matches) the hash */
+	struct domain* cover;
+	/* if the cover is an exact match of the hash */
+	uint8_t exact;
+	uint8_t hash[NSEC3_HASH_LEN];
+	/* the name, in wire format */
+	uint8_t name_size;
+	uint8_t name[MAXDOMAINLEN];
+};
+
+/* The cache of a server process. The database does not change during
+ * the lifetime of a server process, so the cover domains stay valid. */
+struct nsec3_hash_cache {
+	/* number of entries, a power of two */
+	size_t size;
+	struct nsec3_hash_cache_entry* entries;
+};
+
+struct nsec3_hash_cache*
+nsec3_hash_cache_create(region_type* region, size_t size)
+{
+	struct nsec3_hash_cache* cache;
+	size_t n = 1;
+	if(size == 0)
+		return NULL;
+	/* round down to a power of two, the index is a bitmask */
+	while(n*2 <= size)
+		n *= 2;
+	cache = (struct nsec3_hash_cache*)region_alloc(region, sizeof(*cache));
+	cache->size = n;
+	cache->entries = (struct nsec3_hash_cache_entry*)region_alloc_array_zero(
+		region, n, sizeof(struct nsec3_hash_cache_entry));
+	return cache;
+}
+
+static struct nsec3_hash_cache_entry*
+nsec3_hash_cache_entry(struct nsec3_hash_cache* cache, zone_type* zone,
+	const dname_type* dname)
+{
+	uint32_t h = hashlittle(dname_name(dname), dname->name_size,
+		(uint32_t)(size_t)zone);
+	return &cache->entries[h & (cache->size-1)];
+}
+
+/* hash the name and find the cover, or get it from the cache */
+static int
+nsec3_hash_and_find_cover(zone_type* zone, const dname_type* dname,
+	uint8_t* hash, domain_type** cover)
+{
+	struct nsec3_hash_cache* cache = nsd.nsec3_hash_cache;
+	struct nsec3_hash_cache_entry* e = NULL;
+	int exact;
+	if(cache) {
+		e = nsec3_hash_cache_entry(cache, zone, dname);
+		if(e->zone == zone && e->name_size == dname->name_size &&
+			memcmp(e->name, dname_name(dname), e->name_size) == 0) {
+#ifdef BIND8_STATS
+			if(nsd.st) nsd.st->nsec3cache++;
+#endif
+			memmove(hash, e->hash, NSEC3_HASH_LEN);
+			*cover = e->cover;
+			return e->exact;
+		}
+	}
+#ifdef BIND8_STATS
+	if(nsd.st) nsd.st->nsec3hash++;
+#endif
+	nsec3_hash_and_store(zone, dname, hash);
+	exact = nsec3_find_cover(zone, hash, NSEC3_HASH_LEN, cover);
+	if(e) {
+		e->zone = zone;
+		e->cover = *cover;
+		e->exact = (uint8_t)exact;
+		memmove(e->hash, hash, NSEC3_HASH_LEN);
+		e->name_size = (uint8_t)dname->name_size;
+		memmove(e->name, dname_name(dname), dname->name_size);
+	}
+	return exact;
+}
+
 /* add the NSEC3 rrset to the query answer at the given domain */
 static void
 nsec3_add_rrset(struct query* query, struct answer* answer,
@@ -882,8 +1124,7 @@ nsec3_add_nonexist_proof(struct query* query, struct answer* answer,
 	to_prove = dname_partial_copy(query->region, qname,
 		dname_label_match_count(qname, domain_dname(encloser))+1);
 	/* generate proof that one label below closest encloser does not exist */
-	nsec3_hash_and_store(query->zone, to_prove, hash);
-	if(nsec3_find_cover(query->zone, hash, sizeof(hash), &cover))
+	if(nsec3_hash_and_find_cover(query->zone, to_prove, hash, &cover))
 	{
 		/* exact match, hash collision */
 		domain_type* walk;
@@ -11,6 +11,7 @@
 
 #ifdef NSEC3
 struct udb_ptr;
+struct nsec3_hash_cache;
 struct domain;
 struct dname;
 struct region;
@@ -107,6 +108,10 @@ void nsec3_precompile_newparam(struct namedb* db, struct zone* zone);
 /* create b32.zone for a hash, allocated in the region */
 const struct dname* nsec3_b32_create(struct region* region, struct zone* zone,
 	unsigned char* hash);
+/* create the cache of hashes of nonexistent names for a server process,
+ * with size entries, returns NULL for size 0 */
+struct nsec3_hash_cache* nsec3_hash_cache_create(struct region* region,
+	size_t size);
 /* create trees for nsec3 updates and lookups in zone */
 void nsec3_zone_trees_create(struct region* region, struct zone* zone);
 /* lookup zone that contains domain's nsec3 trees */
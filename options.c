@@ -11,6 +11,7 @@
 #include <stdio.h>
 #include <sys/stat.h>
 #include <errno.h>
+#include <ctype.h>
 #ifdef HAVE_IFADDRS_H
 #include <ifaddrs.h>
 #endif
@@ -29,6 +30,7 @@
 #include "rrl.h"
 #include "bitset.h"
 #include "xfrd.h"
+#include "lookup3.h"
 
 #include "configparser.h"
 config_parser_state_type* cfg_parser = 0;
@@ -38,6 +40,10 @@ int c_lex(void);
 int c_wrap(void);
 int c_lex_destroy(void);
 extern char* c_text;
+static void acl_trie_delete(struct acl_trie* trie);
+static void zone_hash_insert(struct nsd_options* opt,
+	struct zone_options* zone);
+static void zone_hash_delete(struct nsd_options* opt, const dname_type* apex);
 
 static int
 rbtree_strcmp(const void* p1, const void* p2)
@@ -57,6 +63,8 @@ nsd_options_create(region_type* region)
 	opt->region = region;
 	opt->zone_options = rbtree_create(region,
 		(int (*)(const void *, const void *)) dname_compare);
+	opt->zone_hash = NULL;
+	opt->zone_hash_size = 0;
 	opt->configfile = NULL;
 	opt->zonestatnames = rbtree_create(opt->region, rbtree_strcmp);
 	opt->patterns = rbtree_create(region, rbtree_strcmp);
@@ -101,6 +109,15 @@ nsd_options_create(region_type* region)
 	opt->reuseport = 0;
 	opt->xfrd_tcp_max = 128;
 	opt->xfrd_tcp_pipeline = 128;
+	opt->xfrd_primary_rate_limit = 0;
+	opt->xfrd_startup_spread = 0;
+	opt->xfrd_catalog_refresh_rate = 1000;
+	opt->xfrd_notify_max = XFRD_NOTIFY_MAX_DEFAULT;
+	opt->xfrd_notify_rate_limit = 0;
+	opt->xfr_tsig_sign_every = 1;
+	opt->nsec3_precompile_workers = 1;
+	opt->nsec3_hash_cache_size = 1024;
+	opt->db_huge_pages = 0;
 	opt->statistics = 0;
 	opt->chroot = 0;
 	opt->username = USER;
@@ -136,10 +153,18 @@ nsd_options_create(region_type* region)
 	opt->dnstap_version = NULL;
 	opt->dnstap_log_auth_query_messages = 0;
 	opt->dnstap_log_auth_response_messages = 0;
+	opt->dnstap_sample_rate = 1;
+	opt->dnstap_log_zones = NULL;
+	opt->dnstap_log_qtypes = NULL;
+	opt->dnstap_log_rcodes = NULL;
+	opt->dnstap_log_min_response_size = 0;
+	opt->dnstap_log_truncated = 0;
 #endif
 	opt->reload_config = 0;
 	opt->zonefiles_check = 1;
 	opt->zonefiles_write = ZONEFILES_WRITE_INTERVAL;
+	opt->zonefiles_write_background = 0;
+	opt->zonefiles_lazy_load = 0;
 	opt->xfrd_reload_timeout = 1;
 	opt->tls_service_key = NULL;
 	opt->tls_service_ocsp = NULL;
@@ -182,6 +207,7 @@ nsd_options_insert_zone(struct nsd_options* opt, struct zone_options* zone)
 	zone->node.key = dname;
 	if(!rbtree_insert(opt->zone_options, (rbnode_type*)zone))
 		return 0;
+	zone_hash_insert(opt, zone);
 	return 1;
 }
 
@@ -510,12 +536,16 @@ parse_zone_list_file(struct nsd_options* opt)
 	*/
 	char hdr[64];
 	char buf[1024];
+	/* offset of the line in buf, counted here, because a ftello for
+	 * every line is a noticeable part of the time for large files */
+	off_t off, lineoff;
 	
 	/* create empty data structures */
 	opt->zonefree = rbtree_create(opt->region, comp_zonebucket);
 	opt->zonelist = NULL;
 	opt->zonefree_number = 0;
 	opt->zonelist_off = 0;
+	opt->zonelist_batch = 0;
 
 	/* try to open the zonelist file, an empty or nonexist file is OK */
 	opt->zonelist = fopen(opt->zonelistfile, "r+");
@@ -537,9 +567,12 @@ parse_zone_list_file(struct nsd_options* opt)
 		return 0;
 	}
 	buf[sizeof(buf)-1]=0;
+	off = (off_t)strlen(ZONELIST_HEADER);
 
 	/* read entries in file */
 	while(fgets(buf, sizeof(buf), opt->zonelist)) {
+		lineoff = off;
+		off += (off_t)strlen(buf);
 		/* skip comments and empty lines */
 		if(buf[0] == 0 || buf[0] == '\n' || buf[0] == '#')
 			continue;
@@ -565,7 +598,7 @@ parse_zone_list_file(struct nsd_options* opt)
 			/* store offset and line size for zone entry */
 			/* and create zone entry in zonetree */
 			(void)zone_list_member_zone_insert(opt, nm, patnm,
-				linesize, ftello(opt->zonelist)-linesize,
+				linesize, lineoff,
 				NULL, NULL);
 
 		} else if(strncmp(buf, "cat ", 4) == 0) {
@@ -597,21 +630,20 @@ parse_zone_list_file(struct nsd_options* opt)
 			/* store offset and line size for zone entry */
 			/* and create zone entry in zonetree */
 			(void)zone_list_member_zone_insert(opt, nm, patnm,
-				linesize, ftello(opt->zonelist)-linesize,
+				linesize, lineoff,
 				mem_idnm, NULL);
 
 		} else if(strncmp(buf, "del ", 4) == 0) {
 			/* store offset and line size for deleted entry */
 			int linesize = strlen(buf);
-			zone_list_free_insert(opt, linesize,
-				ftello(opt->zonelist)-linesize);
+			zone_list_free_insert(opt, linesize, lineoff);
 		} else {
 			log_msg(LOG_WARNING, "bad data in %s, '%s'", opt->zonelistfile,
 				buf);
 		}
 	}
 	/* store EOF offset */
-	opt->zonelist_off = ftello(opt->zonelist);
+	opt->zonelist_off = off;
 	return 1;
 }
 
@@ -621,6 +653,7 @@ zone_options_delete(struct nsd_options* opt, struct zone_options* zone)
 	struct catalog_member_zone* member_zone = as_catalog_member_zone(zone);
 
 	rbtree_delete(opt->zone_options, zone->node.key);
+	zone_hash_delete(opt, (const dname_type*)zone->node.key);
 	region_recycle(opt->region, (void*)zone->node.key, dname_total_size(
 		(dname_type*)zone->node.key));
 	if(!member_zone) {
@@ -645,6 +678,17 @@ zone_options_delete(struct nsd_options* opt, struct zone_options* zone)
 }
 
 
+/* flush the zonelist file, unless in a batch of changes */
+static void
+zone_list_flush(struct nsd_options* opt)
+{
+	if(opt->zonelist_batch)
+		return;
+	if(fflush(opt->zonelist) != 0) {
+		log_msg(LOG_ERR, "fflush %s: %s", opt->zonelistfile, strerror(errno));
+	}
+}
+
 /* add a new zone to the zonelist */
 struct zone_options*
 zone_list_add_or_cat(struct nsd_options* opt, const char* zname,
@@ -714,9 +758,7 @@ zone_list_add_or_cat(struct nsd_options* opt, const char* zname,
 		opt->zonelist_off = ftello(opt->zonelist);
 		if(opt->zonelist_off == -1)
 			log_msg(LOG_ERR, "ftello(%s): %s", opt->zonelistfile, strerror(errno));
-		if(fflush(opt->zonelist) != 0) {
-			log_msg(LOG_ERR, "fflush %s: %s", opt->zonelistfile, strerror(errno));
-		}
+		zone_list_flush(opt);
 		return zone;
 	}
 	b = (struct zonelist_bucket*)rbtree_search(opt->zonefree,
@@ -724,7 +766,9 @@ zone_list_add_or_cat(struct nsd_options* opt, const char* zname,
 	if(!b || b->list == NULL) {
 		/* no empty place, append to file */
 		zone->off = opt->zonelist_off;
-		if(fseeko(opt->zonelist, zone->off, SEEK_SET) == -1) {
+		/* a seek flushes the stdio buffer, appends do not need it */
+		if(ftello(opt->zonelist) != zone->off &&
+			fseeko(opt->zonelist, zone->off, SEEK_SET) == -1) {
 			log_msg(LOG_ERR, "fseeko(%s): %s", opt->zonelistfile, strerror(errno));
 			log_msg(LOG_ERR, "zone %s could not be added", zname);
 			zone_options_delete(opt, zone);
@@ -742,9 +786,7 @@ zone_list_add_or_cat(struct nsd_options* opt, const char* zname,
 			return NULL;
 		}
 		opt->zonelist_off += zone->linesize;
-		if(fflush(opt->zonelist) != 0) {
-			log_msg(LOG_ERR, "fflush %s: %s", opt->zonelistfile, strerror(errno));
-		}
+		zone_list_flush(opt);
 		return zone;
 	}
 	/* reuse empty spot */
@@ -767,9 +809,7 @@ zone_list_add_or_cat(struct nsd_options* opt, const char* zname,
 		zone_options_delete(opt, zone);
 		return NULL;
 	}
-	if(fflush(opt->zonelist) != 0) {
-		log_msg(LOG_ERR, "fflush %s: %s", opt->zonelistfile, strerror(errno));
-	}
+	zone_list_flush(opt);
 
 	/* snip off and recycle element */
 	b->list = e->next;
@@ -803,7 +843,9 @@ zone_list_del(struct nsd_options* opt, struct zone_options* zone)
 	zone_options_delete(opt, zone);
 
 	/* see if we need to compact: it is going to halve the zonelist */
-	if(opt->zonefree_number > opt->zone_options->count) {
+	if(opt->zonelist_batch) {
+		return;
+	} else if(opt->zonefree_number > opt->zone_options->count) {
 		zone_list_compact(opt);
 	} else {
 		if(fflush(opt->zonelist) != 0) {
@@ -811,6 +853,26 @@ zone_list_del(struct nsd_options* opt, struct zone_options* zone)
 		}
 	}
 }
+
+void
+zone_list_batch_start(struct nsd_options* opt)
+{
+	opt->zonelist_batch = 1;
+}
+
+void
+zone_list_batch_end(struct nsd_options* opt)
+{
+	opt->zonelist_batch = 0;
+	if(!opt->zonelist)
+		return;
+	/* compact once for all the deletes of the batch */
+	if(opt->zonefree_number > opt->zone_options->count) {
+		zone_list_compact(opt);
+	} else if(fflush(opt->zonelist) != 0) {
+		log_msg(LOG_ERR, "fflush %s: %s", opt->zonelistfile, strerror(errno));
+	}
+}
 /* postorder delete of zonelist free space tree */
 static void
 delbucket(region_type* region, struct zonelist_bucket* b)
@@ -1099,12 +1161,14 @@ pattern_options_create(region_type* region)
 	p->rrl_whitelist = 0;
 #endif
 	p->multi_primary_check = 0;
+	p->probe_primaries = 0;
 	p->store_ixfr = 0;
 	p->store_ixfr_is_default = 1;
 	p->ixfr_size = IXFR_SIZE_DEFAULT;
 	p->ixfr_size_is_default = 1;
 	p->ixfr_number = IXFR_NUMBER_DEFAULT;
 	p->ixfr_number_is_default = 1;
+	p->ixfr_binary = 0;
 	p->create_ixfr = 0;
 	p->create_ixfr_is_default = 1;
 	p->verify_zone = VERIFY_ZONE_INHERIT;
@@ -1134,6 +1198,8 @@ acl_delete(region_type* region, struct acl_options* acl)
 		region_recycle(region, (void*)acl->tls_auth_name,
 			strlen(acl->tls_auth_name)+1);
 	/* key_options is a convenience pointer, not owned by the acl */
+	if(acl->trie)
+		acl_trie_delete(acl->trie);
 	region_recycle(region, acl, sizeof(*acl));
 }
 
@@ -1205,6 +1271,8 @@ copy_acl(region_type* region, struct acl_options* a)
 	b->next = NULL;
 	b->key_options = NULL;
 	b->tls_auth_options = NULL;
+	b->trie = NULL;
+	b->trie_short = 0;
 	return b;
 }
 
@@ -1305,12 +1373,14 @@ copy_pat_fixed(region_type* region, struct pattern_options* orig,
 	orig->rrl_whitelist = p->rrl_whitelist;
 #endif
 	orig->multi_primary_check = p->multi_primary_check;
+	orig->probe_primaries = p->probe_primaries;
 	orig->store_ixfr = p->store_ixfr;
 	orig->store_ixfr_is_default = p->store_ixfr_is_default;
 	orig->ixfr_size = p->ixfr_size;
 	orig->ixfr_size_is_default = p->ixfr_size_is_default;
 	orig->ixfr_number = p->ixfr_number;
 	orig->ixfr_number_is_default = p->ixfr_number_is_default;
+	orig->ixfr_binary = p->ixfr_binary;
 	orig->create_ixfr = p->create_ixfr;
 	orig->create_ixfr_is_default = p->create_ixfr_is_default;
 	orig->verify_zone = p->verify_zone;
@@ -1443,6 +1513,7 @@ pattern_options_equal(struct pattern_options* p, struct pattern_options* q)
 	if(p->rrl_whitelist != q->rrl_whitelist) return 0;
 #endif
 	if(!booleq(p->multi_primary_check,q->multi_primary_check)) return 0;
+	if(!booleq(p->probe_primaries,q->probe_primaries)) return 0;
 	if(p->size_limit_xfr != q->size_limit_xfr) return 0;
 	if(!booleq(p->store_ixfr,q->store_ixfr)) return 0;
 	if(!booleq(p->store_ixfr_is_default,q->store_ixfr_is_default)) return 0;
@@ -1450,6 +1521,7 @@ pattern_options_equal(struct pattern_options* p, struct pattern_options* q)
 	if(!booleq(p->ixfr_size_is_default,q->ixfr_size_is_default)) return 0;
 	if(p->ixfr_number != q->ixfr_number) return 0;
 	if(!booleq(p->ixfr_number_is_default,q->ixfr_number_is_default)) return 0;
+	if(!booleq(p->ixfr_binary,q->ixfr_binary)) return 0;
 	if(!booleq(p->create_ixfr,q->create_ixfr)) return 0;
 	if(!booleq(p->create_ixfr_is_default,q->create_ixfr_is_default)) return 0;
 	if(p->verify_zone != q->verify_zone) return 0;
@@ -1578,6 +1650,8 @@ unmarshal_acl(region_type* r, struct buffer* b)
 	acl->next = NULL;
 	acl->key_options = NULL;
 	acl->tls_auth_options = NULL;
+	acl->trie = NULL;
+	acl->trie_short = 0;
 	acl->ip_address_spec = unmarshal_str(r, b);
 	acl->key_name = unmarshal_str(r, b);
 	acl->tls_auth_name = unmarshal_str(r, b);
@@ -1685,12 +1759,14 @@ pattern_options_marshal(struct buffer* b, struct pattern_options* p)
 	marshal_u32(b, p->min_expire_time);
 	marshal_u8(b, p->min_expire_time_expr);
 	marshal_u8(b, p->multi_primary_check);
+	marshal_u8(b, p->probe_primaries);
 	marshal_u8(b, p->store_ixfr);
 	marshal_u8(b, p->store_ixfr_is_default);
 	marshal_u64(b, p->ixfr_size);
 	marshal_u8(b, p->ixfr_size_is_default);
 	marshal_u32(b, p->ixfr_number);
 	marshal_u8(b, p->ixfr_number_is_default);
+	marshal_u8(b, p->ixfr_binary);
 	marshal_u8(b, p->create_ixfr);
 	marshal_u8(b, p->create_ixfr_is_default);
 	marshal_u8(b, p->verify_zone);
@@ -1739,12 +1815,14 @@ pattern_options_unmarshal(region_type* r, struct buffer* b)
 	p->min_expire_time = unmarshal_u32(b);
 	p->min_expire_time_expr = unmarshal_u8(b);
 	p->multi_primary_check = unmarshal_u8(b);
+	p->probe_primaries = unmarshal_u8(b);
 	p->store_ixfr = unmarshal_u8(b);
 	p->store_ixfr_is_default = unmarshal_u8(b);
 	p->ixfr_size = unmarshal_u64(b);
 	p->ixfr_size_is_default = unmarshal_u8(b);
 	p->ixfr_number = unmarshal_u32(b);
 	p->ixfr_number_is_default = unmarshal_u8(b);
+	p->ixfr_binary = unmarshal_u8(b);
 	p->create_ixfr = unmarshal_u8(b);
 	p->create_ixfr_is_default = unmarshal_u8(b);
 	p->verify_zone = unmarshal_u8(b);
@@ -1813,6 +1891,7 @@ key_options_desetup(region_type* region, struct key_options* key)
 	/* keep tsig_key pointer so that existing references keep valid */
 	if(!key->tsig_key)
 		return;
+	tsig_key_clear_state(key->tsig_key);
 	/* name stays the same */
 	if(key->tsig_key->data) {
 		/* wipe secret! */
@@ -1844,6 +1923,10 @@ key_options_setup(region_type* region, struct key_options* key)
 		}
 		key->tsig_key->size = 0;
 		key->tsig_key->data = NULL;
+		key->tsig_key->state = NULL;
+		key->tsig_key->state_algorithm = NULL;
+	} else {
+		tsig_key_clear_state(key->tsig_key);
 	}
 	size = b64_pton(key->secret, data, sizeof(data));
 	if(size == -1) {
@@ -1940,6 +2023,216 @@ acl_check_incoming_block_proxy(struct acl_options* acl, struct query* q,
 	return 0;
 }
 
+/* minimum number of elements in an acl list to compile it into a trie */
+#define ACL_TRIE_MIN 32
+
+/* acl element stored in the trie */
+struct acl_trie_item {
+	struct acl_trie_item* next;
+	struct acl_options* acl;
+	/* position of the element in the list */
+	int number;
+};
+
+/* node in the binary trie on the bits of the address */
+struct acl_trie_node {
+	struct acl_trie_node* child[2];
+	/* the elements with a prefix that ends at this node */
+	struct acl_trie_item* items;
+};
+
+/*
+ * acl list compiled into a trie. The elements that match an address are
+ * found on the path of the address bits from the root. Ranges and masks
+ * that are not a prefix are kept in a list that is always checked.
+ */
+struct acl_trie {
+	region_type* region;
+	struct acl_trie_node* root4;
+	struct acl_trie_node* root6;
+	struct acl_trie_item* other;
+	/* the last element of the other list, to append to it */
+	struct acl_trie_item* other_last;
+};
+
+/* the first match and first blocked match of a trie lookup */
+struct acl_trie_result {
+	struct acl_options* match;
+	int match_num;
+	struct acl_options* block;
+	int block_num;
+};
+
+static void
+acl_trie_delete(struct acl_trie* trie)
+{
+	region_destroy(trie->region);
+}
+
+/* the prefix length of the acl address, or -1 if it is not a prefix */
+static int
+acl_prefix_len(struct acl_options* acl)
+{
+	const uint8_t* m;
+	size_t i, sz = acl->is_ipv6?16:4;
+	int len = 0;
+	if(acl->rangetype == acl_range_single)
+		return (int)sz*8;
+	if(acl->rangetype != acl_range_mask &&
+		acl->rangetype != acl_range_subnet)
+		return -1;
+	m = acl->is_ipv6?(const uint8_t*)&acl->range_mask.addr6:
+		(const uint8_t*)&acl->range_mask.addr;
+	for(i=0; i<sz*8; i++) {
+		if(!(m[i/8] & (0x80>>(i&7))))
+			break;
+		len++;
+	}
+	/* the rest of the mask must be zero */
+	for(; i<sz*8; i++) {
+		if(m[i/8] & (0x80>>(i&7)))
+			return -1;
+	}
+	return len;
+}
+
+static void
+acl_trie_insert(struct acl_trie* trie, struct acl_options* acl, int number)
+{
+	struct acl_trie_item* item = (struct acl_trie_item*)region_alloc(
+		trie->region, sizeof(*item));
+	struct acl_trie_node** n;
+	struct acl_trie_item** p;
+	const uint8_t* a;
+	int i, len = acl_prefix_len(acl);
+	item->next = NULL;
+	item->acl = acl;
+	item->number = number;
+	/* the elements are appended, so the lists are in list order */
+	if(len == -1
+#ifndef INET6
+		|| acl->is_ipv6
+#endif
+		) {
+		if(trie->other_last)
+			trie->other_last->next = item;
+		else	trie->other = item;
+		trie->other_last = item;
+		return;
+	}
+	n = acl->is_ipv6?&trie->root6:&trie->root4;
+	a = acl->is_ipv6?(const uint8_t*)&acl->addr.addr6:
+		(const uint8_t*)&acl->addr.addr;
+	for(i=0; ; i++) {
+		if(!*n)
+			*n = (struct acl_trie_node*)region_alloc_zero(
+				trie->region, sizeof(struct acl_trie_node));
+		if(i == len)
+			break;
+		n = &(*n)->child[(a[i/8]>>(7-(i&7)))&1];
+	}
+	for(p = &(*n)->items; *p; p = &(*p)->next)
+		;
+	*p = item;
+}
+
+int
+acl_list_compile(struct acl_options* acl)
+{
+	struct acl_options* p;
+	struct acl_trie* trie;
+	region_type* region;
+	int number = 0;
+	if(!acl)
+		return 0;
+	if(acl->trie)
+		return 1;
+	if(acl->trie_short)
+		return 0;
+	for(p=acl; p && number < ACL_TRIE_MIN; p=p->next)
+		number++;
+	if(number < ACL_TRIE_MIN) {
+		/* do not count the list again on the next lookup */
+		acl->trie_short = 1;
+		return 0;
+	}
+	region = region_create(xalloc, free);
+	trie = (struct acl_trie*)region_alloc_zero(region, sizeof(*trie));
+	trie->region = region;
+	number = 0;
+	for(p=acl; p; p=p->next)
+		acl_trie_insert(trie, p, number++);
+	acl->trie = trie;
+	return 1;
+}
+
+/* check the elements, and note the first match and first blocked match.
+ * The elements are in list order, elements after the blocked match that
+ * is already found do not change the result. */
+static void
+acl_trie_items_check(struct acl_trie_item* item, struct query* q,
+	struct acl_trie_result* res)
+{
+	for(; item; item = item->next) {
+		if(res->block && item->number > res->block_num)
+			break;
+		if(!acl_addr_matches(item->acl, q) ||
+			!acl_key_matches(item->acl, q))
+			continue;
+		if(!res->match || item->number < res->match_num) {
+			res->match = item->acl;
+			res->match_num = item->number;
+		}
+		if(item->acl->blocked && (!res->block ||
+			item->number < res->block_num)) {
+			res->block = item->acl;
+			res->block_num = item->number;
+		}
+	}
+}
+
+/* check the compiled acl list, same result as the list walk */
+static int
+acl_trie_check(struct acl_trie* trie, struct query* q,
+	struct acl_options** reason)
+{
+	struct acl_trie_result res;
+	struct acl_trie_node* n = NULL;
+	const uint8_t* a = NULL;
+	int i, bits = 0;
+	memset(&res, 0, sizeof(res));
+	if(((struct sockaddr_storage*)&q->client_addr)->ss_family == AF_INET) {
+		a = (const uint8_t*)&((struct sockaddr_in*)&q->client_addr)->
+			sin_addr;
+		bits = 32;
+		n = trie->root4;
+	}
+#ifdef INET6
+	else if(((struct sockaddr_storage*)&q->client_addr)->ss_family ==
+		AF_INET6) {
+		a = (const uint8_t*)&((struct sockaddr_in6*)&q->client_addr)->
+			sin6_addr;
+		bits = 128;
+		n = trie->root6;
+	}
+#endif
+	for(i=0; n; i++) {
+		acl_trie_items_check(n->items, q, &res);
+		if(i == bits)
+			break;
+		n = n->child[(a[i/8]>>(7-(i&7)))&1];
+	}
+	acl_trie_items_check(trie->other, q, &res);
+	if(res.block) {
+		if(reason)
+			*reason = res.block;
+		return -1;
+	}
+	if(reason)
+		*reason = res.match;
+	return res.match?res.match_num:-1;
+}
+
 int
 acl_check_incoming(struct acl_options* acl, struct query* q,
 	struct acl_options** reason)
@@ -1952,6 +2245,15 @@ acl_check_incoming(struct acl_options* acl, struct query* q,
 	int number = 0;
 	struct acl_options* match = 0;
 
+	/* long lists are looked up in the trie, unless the tls_auth of
+	 * the elements has to be checked in turn */
+#ifdef HAVE_SSL
+	if(!q->tls_auth && acl_list_compile(acl))
+#else
+	if(acl_list_compile(acl))
+#endif
+		return acl_trie_check(acl->trie, q, reason);
+
 	if(reason)
 		*reason = NULL;
 
@@ -2563,10 +2865,136 @@ config_make_zonefile(struct zone_options* zone, struct nsd* nsd)
 	return f;
 }
 
+/*
+ * The zone_options are also in an open addressing hash table, with
+ * Robin Hood insertion, so zone_options_find needs no tree search.
+ * The rbtree stays for the ordered walks over the zones.
+ */
+struct zone_options_slot {
+	struct zone_options* zone;
+	uint32_t hash;
+};
+
+/* initial number of slots in the zone hash table */
+#define ZONE_HASH_START 64
+
+/* hash of the zone name, case insensitive like dname_compare */
+static uint32_t
+zone_hash_dname(const dname_type* dname)
+{
+	uint8_t buf[MAXDOMAINLEN];
+	const uint8_t* name = dname_name(dname);
+	size_t i;
+	for(i=0; i<dname->name_size; i++)
+		buf[i] = DNAME_NORMALIZE(name[i]);
+	return hashlittle(buf, dname->name_size, 0);
+}
+
+/* distance of the slot from the home slot of its hash */
+static size_t
+zone_hash_dist(struct nsd_options* opt, size_t slot, uint32_t hash)
+{
+	return (slot - (hash & (opt->zone_hash_size-1))) &
+		(opt->zone_hash_size-1);
+}
+
+/* put the zone in the table, the table must have an empty slot */
+static void
+zone_hash_put(struct nsd_options* opt, struct zone_options* zone,
+	uint32_t hash)
+{
+	size_t slot = hash & (opt->zone_hash_size-1), dist = 0;
+	struct zone_options_slot cur, tmp;
+	cur.zone = zone;
+	cur.hash = hash;
+	while(opt->zone_hash[slot].zone) {
+		size_t d = zone_hash_dist(opt, slot, opt->zone_hash[slot].hash);
+		if(d < dist) {
+			/* take the slot from the element that is closer to
+			 * its home, and continue with that element */
+			tmp = opt->zone_hash[slot];
+			opt->zone_hash[slot] = cur;
+			cur = tmp;
+			dist = d;
+		}
+		slot = (slot+1) & (opt->zone_hash_size-1);
+		dist++;
+	}
+	opt->zone_hash[slot] = cur;
+}
+
+static void
+zone_hash_insert(struct nsd_options* opt, struct zone_options* zone)
+{
+	/* keep the table at most half full */
+	if(opt->zone_options->count*2 > opt->zone_hash_size) {
+		struct zone_options_slot* old = opt->zone_hash;
+		size_t i, oldsize = opt->zone_hash_size;
+		opt->zone_hash_size = oldsize?oldsize*2:ZONE_HASH_START;
+		opt->zone_hash = (struct zone_options_slot*)region_alloc_array_zero(
+			opt->region, opt->zone_hash_size, sizeof(*old));
+		for(i=0; i<oldsize; i++) {
+			if(old[i].zone)
+				zone_hash_put(opt, old[i].zone, old[i].hash);
+		}
+		region_recycle(opt->region, old, oldsize*sizeof(*old));
+	}
+	zone_hash_put(opt, zone, zone_hash_dname(
+		(const dname_type*)zone->node.key));
+}
+
+/* find the slot of the zone, or -1 */
+static ssize_t
+zone_hash_find(struct nsd_options* opt, const dname_type* apex)
+{
+	uint32_t hash;
+	size_t slot, dist = 0;
+	if(!opt->zone_hash_size)
+		return -1;
+	hash = zone_hash_dname(apex);
+	slot = hash & (opt->zone_hash_size-1);
+	while(opt->zone_hash[slot].zone) {
+		/* an element further from home than this one would be, means
+		 * that this one is not in the table */
+		if(zone_hash_dist(opt, slot, opt->zone_hash[slot].hash) < dist)
+			return -1;
+		if(opt->zone_hash[slot].hash == hash && dname_compare(apex,
+			(const dname_type*)opt->zone_hash[slot].zone->node.key)
+			== 0)
+			return (ssize_t)slot;
+		slot = (slot+1) & (opt->zone_hash_size-1);
+		dist++;
+	}
+	return -1;
+}
+
+static void
+zone_hash_delete(struct nsd_options* opt, const dname_type* apex)
+{
+	ssize_t found = zone_hash_find(opt, apex);
+	size_t slot, next;
+	if(found == -1)
+		return;
+	/* shift the following elements back, towards their home slot */
+	slot = (size_t)found;
+	next = (slot+1) & (opt->zone_hash_size-1);
+	while(opt->zone_hash[next].zone && zone_hash_dist(opt, next,
+		opt->zone_hash[next].hash) != 0) {
+		opt->zone_hash[slot] = opt->zone_hash[next];
+		slot = next;
+		next = (next+1) & (opt->zone_hash_size-1);
+	}
+	opt->zone_hash[slot].zone = NULL;
+	opt->zone_hash[slot].hash = 0;
+}
+
 struct zone_options*
 zone_options_find(struct nsd_options* opt, const struct dname* apex)
 {
-	return (struct zone_options*) rbtree_search(opt->zone_options, apex);
+	ssize_t slot = zone_hash_find(opt, apex);
+	if(slot == -1)
+		return NULL;
+	return opt->zone_hash[slot].zone;
 }
 
 struct acl_options*
@@ -2662,6 +3090,8 @@ parse_acl_info(region_type* region, char* ip, const char* key)
 	acl->key_options = 0;
 	acl->tls_auth_options = 0;
 	acl->tls_auth_name = 0;
+	acl->trie = 0;
+	acl->trie_short = 0;
 	acl->is_ipv6 = 0;
 	acl->port = 0;
 	memset(&acl->addr, 0, sizeof(union acl_addr_storage));
@@ -2820,6 +3250,8 @@ config_apply_pattern(struct pattern_options *dest, const char* name)
 		dest->ixfr_number = pat->ixfr_number;
 		dest->ixfr_number_is_default = 0;
 	}
+	if(pat->ixfr_binary)
+		dest->ixfr_binary = pat->ixfr_binary;
 	if(!pat->create_ixfr_is_default) {
 		dest->create_ixfr = pat->create_ixfr;
 		dest->create_ixfr_is_default = 0;
@@ -2837,6 +3269,8 @@ config_apply_pattern(struct pattern_options *dest, const char* name)
 	copy_and_append_acls(&dest->outgoing_interface, pat->outgoing_interface);
 	if(pat->multi_primary_check)
 		dest->multi_primary_check = pat->multi_primary_check;
+	if(pat->probe_primaries)
+		dest->probe_primaries = pat->probe_primaries;
 
 	if(!pat->verify_zone_is_default) {
 		dest->verify_zone = pat->verify_zone;
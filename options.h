@@ -22,6 +22,8 @@ struct tsig_key;
 struct buffer;
 struct nsd;
 struct proxy_protocol_port_list;
+struct acl_trie;
+struct zone_options_slot;
 
 
 typedef struct nsd_options nsd_options_type;
@@ -51,6 +53,10 @@ struct nsd_options {
 	char* configfile;
 	/* options for zones, by apex, contains zone_options */
 	rbtree_type* zone_options;
+	/* hash table of the zone_options, by apex, for zone_options_find */
+	struct zone_options_slot* zone_hash;
+	/* number of slots in zone_hash, a power of two, or 0 */
+	size_t zone_hash_size;
 	/* patterns, by name, contains pattern_options */
 	rbtree_type* patterns;
 
@@ -62,6 +68,8 @@ struct nsd_options {
 	FILE* zonelist;
 	/* last offset in file (or 0 if none) */
 	off_t zonelist_off;
+	/* if set, zonelist writes are not flushed until the batch ends */
+	int zonelist_batch;
 
 	/* tree of zonestat names and their id values, entries are struct
 	 * zonestatname with malloced key=stringname. The number of items
@@ -119,6 +127,10 @@ struct nsd_options {
 	int reload_config;
 	int zonefiles_check;
 	int zonefiles_write;
+	/* write zonefiles from a forked process, reload does not wait */
+	int zonefiles_write_background;
+	/* load primary zonefiles when the zone is first queried */
+	int zonefiles_lazy_load;
 	int log_time_ascii;
 	int round_robin;
 	int minimal_responses;
@@ -128,6 +140,24 @@ struct nsd_options {
 	int xfrd_tcp_max;
 	/* max number of simultaneous requests on xfrd tcp socket */
 	int xfrd_tcp_pipeline;
+	/* max zone transfer requests per second to a primary, 0 unlimited */
+	int xfrd_primary_rate_limit;
+	/* spread the refreshes of zones with data after startup */
+	int xfrd_startup_spread;
+	/* new catalog member zones per second that start refresh, 0 unlimited */
+	int xfrd_catalog_refresh_rate;
+	/* max number of zones that send notifies at the same time */
+	int xfrd_notify_max;
+	/* max notifies per second to a secondary, 0 unlimited */
+	int xfrd_notify_rate_limit;
+	/* TSIG sign every Nth message of an outgoing AXFR or IXFR */
+	int xfr_tsig_sign_every;
+	/* number of processes that hash names for NSEC3 zone precompile */
+	int nsec3_precompile_workers;
+	/* number of entries in the NSEC3 hash cache of a server process */
+	size_t nsec3_hash_cache_size;
+	/* allocate the zone database in chunks of 2MB huge pages */
+	int db_huge_pages;
 
 	/* private key file for TLS */
 	char* tls_service_key;
@@ -203,6 +233,18 @@ struct nsd_options {
 	int dnstap_log_auth_query_messages;
 	/** true to log dnstap AUTH_RESPONSE message events */
 	int dnstap_log_auth_response_messages;
+	/** log the dnstap messages for one in this many client addresses */
+	int dnstap_sample_rate;
+	/** if not NULL, only log dnstap messages for names in these zones */
+	struct dnstap_filter_list* dnstap_log_zones;
+	/** if not NULL, only log dnstap messages for these query types */
+	struct dnstap_filter_list* dnstap_log_qtypes;
+	/** if not NULL, log dnstap responses with these rcodes */
+	struct dnstap_filter_list* dnstap_log_rcodes;
+	/** if not 0, log dnstap responses of at least this size */
+	int dnstap_log_min_response_size;
+	/** true to log truncated dnstap responses */
+	int dnstap_log_truncated;
 
 	/** do answer with server cookie when request contained cookie option */
 	int answer_cookie;
@@ -230,6 +272,17 @@ struct nsd_options {
 	region_type* region;
 };
 
+/*
+ * Entry in a dnstap-log-zone, -qtype or -rcode list.
+ */
+struct dnstap_filter_list {
+	struct dnstap_filter_list* next;
+	/* the qtype or rcode */
+	uint16_t num;
+	/* the zone apex, for dnstap-log-zone */
+	const struct dname* zone;
+};
+
 struct range_option {
 	struct range_option* next;
 	int first;
@@ -305,12 +358,14 @@ struct pattern_options {
 	uint8_t min_expire_time_expr;
 	uint64_t size_limit_xfr;
 	uint8_t multi_primary_check;
+	uint8_t probe_primaries;
 	uint8_t store_ixfr;
 	uint8_t store_ixfr_is_default;
 	uint64_t ixfr_size;
 	uint8_t ixfr_size_is_default;
 	uint32_t ixfr_number;
 	uint8_t ixfr_number_is_default;
+	uint8_t ixfr_binary;
 	uint8_t create_ixfr;
 	uint8_t create_ixfr_is_default;
 	uint8_t verify_zone;
@@ -408,6 +463,11 @@ struct acl_options {
 	/* tls_auth for XoT */
 	const char* tls_auth_name;
 	struct tls_auth_options* tls_auth_options;
+
+	/* lookup trie compiled from the list, on the first element of it */
+	struct acl_trie* trie;
+	/* the list is too short to compile into a trie */
+	uint8_t trie_short;
 } ATTR_PACKED;
 
 /*
@@ -453,6 +513,8 @@ struct zonelist_bucket {
 
 /* default zonefile write interval if database is "", in seconds */
 #define ZONEFILES_WRITE_INTERVAL 3600
+/* default number of zones that send notifies at the same time */
+#define XFRD_NOTIFY_MAX_DEFAULT 128
 
 struct zonestatname {
 	rbnode_type node; /* key is malloced string with cooked zonestat name */
@@ -539,6 +601,10 @@ struct zone_options* zone_list_zone_insert(struct nsd_options* opt,
 void zone_list_del(struct nsd_options* opt, struct zone_options* zone);
 void zone_list_compact(struct nsd_options* opt);
 void zone_list_close(struct nsd_options* opt);
+/* start a batch of zone list changes, the file writes are buffered and
+ * compaction is postponed until zone_list_batch_end */
+void zone_list_batch_start(struct nsd_options* opt);
+void zone_list_batch_end(struct nsd_options* opt);
 
 /* create zonestat name tree , for initially created zones */
 void options_zonestatnames_create(struct nsd_options* opt);
@@ -562,6 +628,9 @@ void key_options_tsig_add(struct nsd_options* opt);
 /* the reason why (the acl) is returned too (or NULL) */
 int acl_check_incoming(struct acl_options* acl, struct query* q,
 	struct acl_options** reason);
+/* compile the acl list into a trie on the address, if the list is long.
+ * returns true if the list has a trie. acl_check_incoming uses it. */
+int acl_list_compile(struct acl_options* acl);
 int acl_addr_matches_host(struct acl_options* acl, struct acl_options* host);
 int acl_addr_matches(struct acl_options* acl, struct query* q);
 int acl_addr_matches_proxy(struct acl_options* acl, struct query* q);
@@ -53,6 +53,7 @@ packet_encode_rr(query_type *q, domain_type *owner, rr_type *rr, uint32_t ttl)
 	uint16_t rdlength = 0;
 	size_t rdlength_pos;
 	uint16_t j;
+	const rrtype_descriptor_type *descriptor;
 
 	assert(q);
 	assert(owner);
@@ -73,8 +74,11 @@ packet_encode_rr(query_type *q, domain_type *owner, rr_type *rr, uint32_t ttl)
 	rdlength_pos = buffer_position(q->packet);
 	buffer_skip(q->packet, sizeof(rdlength));
 
+	/* look up the descriptor once, not for every rdata atom */
+	descriptor = rrtype_descriptor_by_type(rr->type);
+	assert(rr->rdata_count <= descriptor->maximum);
 	for (j = 0; j < rr->rdata_count; ++j) {
-		switch (rdata_atom_wireformat_type(rr->type, j)) {
+		switch (descriptor->wireformat[j]) {
 		case RDATA_WF_COMPRESSED_DNAME:
 			encode_dname(q, rdata_atom_domain(rr->rdatas[j]));
 			break;
@@ -211,7 +211,6 @@ query_reset(query_type *q, size_t maxlen, int is_tcp)
 	 * this call to free_all is free, the block is saved for re-use,
 	 * so no malloc() or free() calls are done.
 	 * at present use of the region is for:
-	 *   o query qname dname_type (255 max).
 	 *   o wildcard expansion domain_type (7*ptr+u32+2bytes)+(5*ptr nsec3)
 	 *   o wildcard expansion for additional section domain_type.
 	 *   o nsec3 hashed name(s) (3 dnames for a nonexist_proof,
@@ -311,14 +310,22 @@ query_addtxt(struct query  *q,
 static int
 process_query_section(query_type *query)
 {
-	uint8_t qnamebuf[MAXDOMAINLEN];
-
-	buffer_set_position(query->packet, QHEADERSZ);
-	/* Lets parse the query name and convert it to lower case.  */
-	if(!packet_read_query_section(query->packet, qnamebuf,
-		&query->qtype, &query->qclass))
+	size_t len;
+
+	/* Lets parse the query name and convert it to lower case, in one
+	 * pass, into the space in the query, and make the radix tree key
+	 * for the lookup in that pass too.  */
+	len = dname_make_in_buffer(query->qname_space,
+		buffer_at(query->packet, QHEADERSZ),
+		buffer_end(query->packet), query->qname_key,
+		&query->qname_keylen);
+	if(len == 0 || !buffer_available_at(query->packet, QHEADERSZ + len,
+		2*sizeof(uint16_t)))
 		return 0;
-	query->qname = dname_make(query->region, qnamebuf, 1);
+	query->qname = (const dname_type*)query->qname_space;
+	buffer_set_position(query->packet, QHEADERSZ + len);
+	query->qtype = buffer_read_u16(query->packet);
+	query->qclass = buffer_read_u16(query->packet);
 	return 1;
 }
 
@@ -414,6 +421,47 @@ process_tsig(struct query* q)
 	return NSD_RC_OK;
 }
 
+/* number of entries in the cache of notifies passed to xfrd */
+#define NOTIFY_FWD_CACHE_SIZE 1024
+/* seconds that a notify for the same zone and serial is not passed again */
+#define NOTIFY_FWD_WINDOW 5
+
+/* notify that was passed to xfrd by this server process */
+struct notify_fwd {
+	/* the zone, or NULL if the entry is not used */
+	struct zone_options* zone;
+	/* the serial in the notify */
+	uint32_t serial;
+	/* when it was passed to xfrd */
+	time_t sent;
+};
+static struct notify_fwd notify_fwd_cache[NOTIFY_FWD_CACHE_SIZE];
+
+/*
+ * See if the notify repeats one that was passed to xfrd a moment ago.
+ * Then xfrd already has the serial, and the notify is only answered.
+ * Notifies without a serial are always passed on.
+ */
+static int
+notify_fwd_is_repeat(struct zone_options* zone, uint32_t serial, time_t now)
+{
+	struct notify_fwd* f = &notify_fwd_cache[
+		((size_t)zone / sizeof(void*)) % NOTIFY_FWD_CACHE_SIZE];
+	return f->zone == zone && f->serial == serial &&
+		now >= f->sent && now - f->sent < NOTIFY_FWD_WINDOW;
+}
+
+/* store the notify that was passed to xfrd */
+static void
+notify_fwd_store(struct zone_options* zone, uint32_t serial, time_t now)
+{
+	struct notify_fwd* f = &notify_fwd_cache[
+		((size_t)zone / sizeof(void*)) % NOTIFY_FWD_CACHE_SIZE];
+	f->zone = zone;
+	f->serial = serial;
+	f->sent = now;
+}
+
 /*
  * Check notify acl and forward to xfrd (or return an error).
  */
@@ -472,6 +520,10 @@ answer_notify(struct nsd* nsd, struct query *query)
 		uint32_t acl_send = htonl(acl_num);
 		uint32_t acl_xfr;
 		size_t pos;
+		uint32_t serial = 0;
+		int have_serial = packet_find_notify_serial(query->packet,
+			&serial);
+		time_t now = time(NULL);
 
 		/* Find priority candidate for request XFR. -1 if no match */
 		acl_num_xfr = acl_check_incoming(
@@ -488,30 +540,47 @@ answer_notify(struct nsd* nsd, struct query *query)
 		sz = buffer_limit(query->packet);
 		if(buffer_limit(query->packet) > MAX_PACKET_SIZE)
 			return query_error(query, NSD_RC_SERVFAIL);
-		/* forward to xfrd for processing
-		   Note. Blocking IPC I/O, but acl is OK. */
-		sz = htons(sz);
-		if(!write_socket(s, &mode, sizeof(mode)) ||
-			!write_socket(s, &sz, sizeof(sz)) ||
-			!write_socket(s, buffer_begin(query->packet),
-				buffer_limit(query->packet)) ||
-			!write_socket(s, &acl_send, sizeof(acl_send)) ||
-			!write_socket(s, &acl_xfr, sizeof(acl_xfr))) {
-			log_msg(LOG_ERR, "error in IPC notify server2main, %s",
-				strerror(errno));
-			return query_error(query, NSD_RC_SERVFAIL);
-		}
-		if(verbosity >= 1) {
-			uint32_t serial = 0;
-			char address[128];
-			addr2str(&query->client_addr, address, sizeof(address));
-			if(packet_find_notify_serial(query->packet, &serial))
-			  VERBOSITY(1, (LOG_INFO, "notify for %s from %s serial %u",
-				dname_to_string(query->qname, NULL), address,
-				(unsigned)serial));
-			else
-			  VERBOSITY(1, (LOG_INFO, "notify for %s from %s",
-				dname_to_string(query->qname, NULL), address));
+		if(have_serial && notify_fwd_is_repeat(zone_opt, serial, now)) {
+			/* xfrd has this serial, the notify is only answered */
+			if(verbosity >= 2) {
+				char address[128];
+				addr2str(&query->client_addr, address,
+					sizeof(address));
+				VERBOSITY(2, (LOG_INFO, "notify for %s from %s "
+					"serial %u is a repeat, not passed on",
+					dname_to_string(query->qname, NULL),
+					address, (unsigned)serial));
+			}
+		} else {
+			/* forward to xfrd for processing
+			   Note. Blocking IPC I/O, but acl is OK. */
+			sz = htons(sz);
+			if(!write_socket(s, &mode, sizeof(mode)) ||
+				!write_socket(s, &sz, sizeof(sz)) ||
+				!write_socket(s, buffer_begin(query->packet),
+					buffer_limit(query->packet)) ||
+				!write_socket(s, &acl_send, sizeof(acl_send)) ||
+				!write_socket(s, &acl_xfr, sizeof(acl_xfr))) {
+				log_msg(LOG_ERR, "error in IPC notify "
+					"server2main, %s", strerror(errno));
+				return query_error(query, NSD_RC_SERVFAIL);
+			}
+			if(have_serial)
+				notify_fwd_store(zone_opt, serial, now);
+			if(verbosity >= 1) {
+				char address[128];
+				addr2str(&query->client_addr, address,
+					sizeof(address));
+				if(have_serial)
+				  VERBOSITY(1, (LOG_INFO, "notify for %s from "
+					"%s serial %u",
+					dname_to_string(query->qname, NULL),
+					address, (unsigned)serial));
+				else
+				  VERBOSITY(1, (LOG_INFO, "notify for %s from "
+					"%s", dname_to_string(query->qname,
+					NULL), address));
+			}
 		}
 
 		/* create notify reply - keep same query contents */
@@ -1308,6 +1377,53 @@ answer_authoritative(struct nsd   *nsd,
 	}
 }
 
+/*
+ * Ask xfrd to have the zonefile read, for a zone that is loaded when it is
+ * first queried. The request is passed like a notify, as a query for the
+ * SOA of the zone. Every server process asks once. Returns true if the
+ * zone is loaded when it is first queried.
+ */
+int
+query_request_zone_load(struct nsd *nsd, zone_type *zone)
+{
+	uint8_t buf[QHEADERSZ+MAXDOMAINLEN+4];
+	buffer_type packet;
+	const dname_type* dname;
+	sig_atomic_t mode = NSD_PASS_TO_XFRD;
+	uint16_t sz;
+	uint32_t acl_send = htonl((uint32_t)-1);
+	int s;
+
+	if(!nsd->options->zonefiles_lazy_load || !nsd->this_child ||
+		!zone->opts || !zone->opts->pattern->zonefile ||
+		zone_is_slave(zone->opts))
+		return 0;
+	if(zone->is_load_tried)
+		return 1;
+	zone->is_load_tried = 1;
+	dname = (const dname_type*)zone->opts->node.key;
+	buffer_create_from(&packet, buf, sizeof(buf));
+	memset(buf, 0, QHEADERSZ);
+	QDCOUNT_SET(&packet, 1);
+	buffer_set_position(&packet, QHEADERSZ);
+	buffer_write(&packet, dname_name(dname), dname->name_size);
+	buffer_write_u16(&packet, TYPE_SOA);
+	buffer_write_u16(&packet, CLASS_IN);
+	buffer_flip(&packet);
+
+	s = nsd->this_child->parent_fd;
+	sz = htons(buffer_limit(&packet));
+	if(!write_socket(s, &mode, sizeof(mode)) ||
+		!write_socket(s, &sz, sizeof(sz)) ||
+		!write_socket(s, buffer_begin(&packet), buffer_limit(&packet)) ||
+		!write_socket(s, &acl_send, sizeof(acl_send)) ||
+		!write_socket(s, &acl_send, sizeof(acl_send))) {
+		log_msg(LOG_ERR, "error in IPC zone load server2main, %s",
+			strerror(errno));
+	}
+	return 1;
+}
+
 /*
  * qname may be different after CNAMEs have been followed from query->qname.
  */
@@ -1406,6 +1522,7 @@ answer_lookup_zone(struct nsd *nsd, struct query *q, answer_type *answer,
 	}
 	if(!q->zone->apex || !q->zone->soa_rrset) {
 		/* zone is configured but not loaded */
+		(void)query_request_zone_load(nsd, q->zone);
 		if(q->cname_count == 0) {
 			RCODE_SET(q->packet, RCODE_SERVFAIL);
 			/* RFC 8914 - Extended DNS Errors
@@ -1523,7 +1640,8 @@ answer_query(struct nsd *nsd, struct query *q)
 
 	answer_init(&answer);
 
-	exact = namedb_lookup(nsd->db, q->qname, &closest_match, &closest_encloser);
+	exact = namedb_lookup_key(nsd->db, q->qname, q->qname_key,
+		q->qname_keylen, &closest_match, &closest_encloser);
 
 	answer_lookup_zone(nsd, q, &answer, 0, exact, closest_match,
 		closest_encloser, q->qname);
@@ -90,6 +90,11 @@ struct query {
 
 	/* Normalized query domain name.  */
 	const dname_type *qname;
+	/* Space for the query domain name, so it needs no allocation.  */
+	uint8_t qname_space[DNAME_MAX_SIZE];
+	/* Radix tree key of the query domain name, for the lookup.  */
+	uint8_t qname_key[MAXDOMAINLEN];
+	size_t qname_keylen;
 
 	/* Query type and class in host byte order.  */
 	uint16_t qtype;
@@ -193,6 +198,12 @@ uint16_t query_get_dname_offset(struct query *query, domain_type *domain)
  */
 void query_clear_dname_offsets(struct query *query, size_t max_offset);
 
+/*
+ * Ask xfrd to read the zonefile of a zone that is loaded when it is first
+ * queried, if not asked before. Returns true if the zone is loaded so.
+ */
+int query_request_zone_load(struct nsd *nsd, zone_type *zone);
+
 /*
  * Clear the compression tables.
  */
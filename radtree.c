@@ -1011,14 +1011,6 @@ struct radnode* radix_prev(struct radnode* n)
 	return NULL;
 }
 
-/** convert one character from domain-name to radname */
-static uint8_t char_d2r(uint8_t c)
-{
-	if(c < 'A') return c+1; /* make space for 00 */
-	else if(c <= 'Z') return c-'A'+'a'; /* lowercase */
-	else return c;
-}
-
 /** convert one character from radname to domain-name (still lowercased) */
 static uint8_t char_r2d(uint8_t c)
 {
@@ -1032,7 +1024,7 @@ static void cpy_d2r(uint8_t* to, const uint8_t* from, int len)
 {
 	int i;
 	for(i=0; i<len; i++)
-		to[i] = char_d2r(from[i]);
+		to[i] = radname_char_d2r(from[i]);
 }
 
 /** copy and convert a range of characters */
@@ -1233,7 +1225,7 @@ struct radnode* radname_search(struct radtree* rt, const uint8_t* d,
 		/* fetch next byte this label */
 		if(lpos < *labstart[lab])
 			/* lpos+1 to skip labelstart, lpos++ to move forward */
-			byte = char_d2r(labstart[lab][++lpos]);
+			byte = radname_char_d2r(labstart[lab][++lpos]);
 		else {
 			if(lab == 0) /* last label - we're done */
 				return n->elem?n:NULL;
@@ -1254,7 +1246,7 @@ struct radnode* radname_search(struct radtree* rt, const uint8_t* d,
 			for(i=0; i<n->array[byte].len; i++) {
 				/* next byte to match */
 				if(lpos < *labstart[lab])
-					b = char_d2r(labstart[lab][++lpos]);
+					b = radname_char_d2r(labstart[lab][++lpos]);
 				else {
 					/* if last label, no match since
 					 * we are in the additional string */
@@ -1335,7 +1327,7 @@ int radname_find_less_equal(struct radtree* rt, const uint8_t* d, size_t max,
 		/* fetch next byte this label */
 		if(lpos < *labstart[lab])
 			/* lpos+1 to skip labelstart, lpos++ to move forward */
-			byte = char_d2r(labstart[lab][++lpos]);
+			byte = radname_char_d2r(labstart[lab][++lpos]);
 		else {
 			if(lab == 0) {
 				/* last label - we're done */
@@ -1383,7 +1375,7 @@ int radname_find_less_equal(struct radtree* rt, const uint8_t* d, size_t max,
 			for(i=0; i<n->array[byte].len; i++) {
 				/* next byte to match */
 				if(lpos < *labstart[lab])
-					b = char_d2r(labstart[lab][++lpos]);
+					b = radname_char_d2r(labstart[lab][++lpos]);
 				else {
 					/* if last label, no match since
 					 * we are in the additional string */
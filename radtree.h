@@ -168,6 +168,14 @@ struct radnode* radix_prev(struct radnode* n);
  *	for(node=radix_first(tree); node; node=radix_next(node))
 */
 
+/** convert one character from domain-name to radname */
+static inline uint8_t radname_char_d2r(uint8_t c)
+{
+	if(c < 'A') return c+1; /* make space for 00 */
+	else if(c <= 'Z') return c-'A'+'a'; /* lowercase */
+	else return c;
+}
+
 /**
  * Create a binary string to represent a domain name
  * @param k: string buffer to store into
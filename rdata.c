@@ -926,6 +926,28 @@ rdata_atom_to_string(buffer_type *output, rdata_zoneformat_type type,
 	return rdata_to_string_table[type](output, rdata, record);
 }
 
+/* size of a literal rdata atom in the rdata block, with its length */
+#define RDATA_ATOM_BLOCK_SIZE(length) \
+	(sizeof(uint16_t) + (((size_t)(length) + 1) & ~((size_t)1)))
+
+size_t
+rdata_atoms_size(uint16_t rrtype, rdata_atom_type *rdatas, size_t rdata_count)
+{
+	size_t i, size = sizeof(rdata_atom_type) * rdata_count;
+	for (i = 0; i < rdata_count; ++i) {
+		if (!rdata_atom_is_domain(rrtype, i))
+			size += RDATA_ATOM_BLOCK_SIZE(rdata_atom_size(rdatas[i]));
+	}
+	return size;
+}
+
+/*
+ * The atoms are allocated in one block in the region, the array of atoms
+ * is followed by the data of the literal atoms, each a 16 bit length and
+ * the data padded to 16 bits. The data is collected in the scratch
+ * buffer, which is copied after the array when the number of atoms is
+ * known.
+ */
 ssize_t
 rdata_wireformat_to_rdata_atoms(region_type *region,
 				domain_table_type *owners,
@@ -934,11 +956,15 @@ rdata_wireformat_to_rdata_atoms(region_type *region,
 				buffer_type *packet,
 				rdata_atom_type **rdatas)
 {
+	/* literal domain names can be compressed in the packet */
+	static uint16_t scratch[(MAX_RDLENGTH + MAXRDATALEN
+		* (MAXDOMAINLEN + 2 * sizeof(uint16_t))) / sizeof(uint16_t)];
 	size_t end = buffer_position(packet) + data_size;
-	size_t i;
+	size_t i, used = 0;
 	rdata_atom_type temp_rdatas[MAXRDATALEN];
 	rrtype_descriptor_type *descriptor = rrtype_descriptor_by_type(rrtype);
-	region_type *temp_region;
+	region_type *temp_region = NULL;
+	uint8_t *block;
 
 	assert(descriptor->maximum <= MAXRDATALEN);
 
@@ -946,8 +972,6 @@ rdata_wireformat_to_rdata_atoms(region_type *region,
 		return -1;
 	}
 
-	temp_region = region_create(xalloc, free);
-
 	for (i = 0; i < descriptor->maximum; ++i) {
 		int is_domain = 0;
 		int is_normalized = 0;
@@ -1051,6 +1075,9 @@ rdata_wireformat_to_rdata_atoms(region_type *region,
 				break;
 			}
 
+			/* most types have no domain names in the rdata */
+			if (!temp_region)
+				temp_region = region_create(xalloc, free);
 			dname = dname_make_from_packet(
 				temp_region, packet, 1, is_normalized);
 			if (!dname || buffer_position(packet) > end) {
@@ -1059,11 +1086,12 @@ rdata_wireformat_to_rdata_atoms(region_type *region,
 				return -1;
 			}
 			if(is_wirestore) {
-				temp_rdatas[i].data = (uint16_t *) region_alloc(
-                                	region, sizeof(uint16_t) + ((size_t)dname->name_size));
+				temp_rdatas[i].data = scratch + used;
 				temp_rdatas[i].data[0] = dname->name_size;
 				memcpy(temp_rdatas[i].data+1, dname_name(dname),
 					dname->name_size);
+				used += RDATA_ATOM_BLOCK_SIZE(dname->name_size)
+					/ sizeof(uint16_t);
 			} else {
 				temp_rdatas[i].domain
 					= domain_table_insert(owners, dname);
@@ -1073,7 +1101,8 @@ rdata_wireformat_to_rdata_atoms(region_type *region,
 			if (buffer_position(packet) + length > end) {
 				if (required) {
 					/* Truncated RDATA.  */
-					region_destroy(temp_region);
+					if (temp_region)
+						region_destroy(temp_region);
 					return -1;
 				} else {
 					break;
@@ -1083,22 +1112,35 @@ rdata_wireformat_to_rdata_atoms(region_type *region,
 				break;
 			}
 
-			temp_rdatas[i].data = (uint16_t *) region_alloc(
-				region, sizeof(uint16_t) + length);
+			temp_rdatas[i].data = scratch + used;
 			temp_rdatas[i].data[0] = length;
 			buffer_read(packet, temp_rdatas[i].data + 1, length);
+			used += RDATA_ATOM_BLOCK_SIZE(length) / sizeof(uint16_t);
 		}
 	}
 
+	if (temp_region)
+		region_destroy(temp_region);
 	if (buffer_position(packet) < end) {
 		/* Trailing garbage.  */
-		region_destroy(temp_region);
 		return -1;
 	}
 
-	*rdatas = (rdata_atom_type *) region_alloc_array_init(
-		region, temp_rdatas, i, sizeof(rdata_atom_type));
-	region_destroy(temp_region);
+	block = (uint8_t *) region_alloc(region,
+		sizeof(rdata_atom_type) * i + used * sizeof(uint16_t));
+	memcpy(block + sizeof(rdata_atom_type) * i, scratch,
+		used * sizeof(uint16_t));
+	*rdatas = (rdata_atom_type *) block;
+	for (used = 0; used < i; ++used) {
+		if (rdata_atom_is_domain(rrtype, used)) {
+			(*rdatas)[used].domain = temp_rdatas[used].domain;
+		} else {
+			(*rdatas)[used].data = (uint16_t *)(block
+				+ sizeof(rdata_atom_type) * i
+				+ ((uint8_t *) temp_rdatas[used].data
+				   - (uint8_t *) scratch));
+		}
+	}
 	return (ssize_t)i;
 }
 
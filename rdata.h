@@ -28,7 +28,8 @@ int rdata_atom_to_string(buffer_type *output, rdata_zoneformat_type type,
  * Split the wireformat RDATA into an array of rdata atoms. Domain
  * names are inserted into the OWNERS table. The number of rdata atoms
  * is returned and the array itself is allocated in REGION and stored
- * in RDATAS.
+ * in RDATAS. The array and the data of the atoms are allocated as one
+ * block, of rdata_atoms_size bytes.
  *
  * Returns -1 on failure.
  */
@@ -39,6 +40,12 @@ ssize_t rdata_wireformat_to_rdata_atoms(region_type *region,
 					buffer_type *packet,
 					rdata_atom_type **rdatas);
 
+/*
+ * The size of the block allocated for the rdata atoms, to recycle it.
+ */
+size_t rdata_atoms_size(uint16_t rrtype, rdata_atom_type *rdatas,
+	size_t rdata_count);
+
 /*
  * Calculate the maximum size of the rdata assuming domain names are
  * not compressed.
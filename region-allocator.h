@@ -35,6 +35,14 @@ typedef struct region region_type;
 
 #endif /* USE_MMAP_ALLOC */
 
+/*
+ * huge page allocator constants, the region chunks are one 2MB page,
+ * minus the header that contains the allocated size.
+ */
+#define HUGEPAGE_SIZE			(2 * 1024 * 1024)
+#define HUGEPAGE_ALLOC_HEADER_SIZE	16
+#define HUGEPAGE_CHUNK_SIZE		(HUGEPAGE_SIZE - HUGEPAGE_ALLOC_HEADER_SIZE)
+
 /*
  * Create a new region.
  */
@@ -1390,15 +1390,13 @@ perform_changezone(RES* ssl, xfrd_state_type* xfrd, char* arg)
 	return 1;
 }
 
-/** perform the addzone command for one zone */
+/** check the zone name and pattern for addzone, returns 0 on error,
+ * -1 if the zone already exists and 1 if it can be added */
 static int
-perform_addzone(RES* ssl, xfrd_state_type* xfrd, char* arg)
+addzone_check(RES* ssl, xfrd_state_type* xfrd, const char* arg,
+	const char* arg2)
 {
 	const dname_type* dname;
-	struct zone_options* zopt;
-	char* arg2 = NULL;
-	if(!find_arg2(ssl, arg, &arg2))
-		return 0;
 
 	/* if we add it to the xfrd now, then xfrd could download AXFR and
 	 * store it and the NSD-reload would see it in the difffile before
@@ -1426,10 +1424,19 @@ perform_addzone(RES* ssl, xfrd_state_type* xfrd, char* arg)
 		region_recycle(xfrd->region, (void*)dname,
 			dname_total_size(dname));
 		(void)ssl_printf(ssl, "zone %s already exists\n", arg);
-		return 1;
+		return -1;
 	}
 	region_recycle(xfrd->region, (void*)dname, dname_total_size(dname));
-	dname = NULL;
+	return 1;
+}
+
+/** add the checked zone to the zonelist and config, and make the addzone
+ * task. The caller schedules the reload. */
+static int
+addzone_apply(RES* ssl, xfrd_state_type* xfrd, const char* arg,
+	const char* arg2)
+{
+	struct zone_options* zopt;
 
 	/* add to zonelist and adds to config in memory */
 	zopt = zone_list_add_or_cat(xfrd->nsd->options, arg, arg2,
@@ -1439,12 +1446,10 @@ perform_addzone(RES* ssl, xfrd_state_type* xfrd, char* arg)
 		(void)ssl_printf(ssl, "error could not add zonelist entry\n");
 		return 0;
 	}
-	/* make addzone task and schedule reload */
+	/* make addzone task */
 	task_new_add_zone(xfrd->nsd->task[xfrd->nsd->mytask],
 		xfrd->last_task, arg, arg2,
 		getzonestatid(xfrd->nsd->options, zopt));
-	zonestat_inc_ifneeded(xfrd);
-	xfrd_set_reload_now(xfrd);
 	/* add to xfrd - catalog consumer zones */
 	if (zone_is_catalog_consumer(zopt)) {
 		xfrd_init_catalog_consumer_zone(xfrd, zopt);
@@ -1458,6 +1463,24 @@ perform_addzone(RES* ssl, xfrd_state_type* xfrd, char* arg)
 	return 1;
 }
 
+/** perform the addzone command for one zone */
+static int
+perform_addzone(RES* ssl, xfrd_state_type* xfrd, char* arg)
+{
+	char* arg2 = NULL;
+	int r;
+	if(!find_arg2(ssl, arg, &arg2))
+		return 0;
+	if((r = addzone_check(ssl, xfrd, arg, arg2)) <= 0)
+		return r != 0;
+	if(!addzone_apply(ssl, xfrd, arg, arg2))
+		return 0;
+	/* schedule reload */
+	zonestat_inc_ifneeded(xfrd);
+	xfrd_set_reload_now(xfrd);
+	return 1;
+}
+
 /** perform the delzone command for one zone */
 static int
 perform_delzone(RES* ssl, xfrd_state_type* xfrd, char* arg)
@@ -1554,24 +1577,77 @@ do_changezone(RES* ssl, xfrd_state_type* xfrd, char* arg)
 	send_ok(ssl);
 }
 
-/** do the addzones command */
+/** a zone from the addzones input, checked and waiting to be added */
+struct addzones_entry {
+	struct addzones_entry* next;
+	char* name;
+	char* pattern;
+};
+
+/** do the addzones command. All lines are read and checked first, then
+ * the zones are added in one batch of zonelist writes and one reload. */
 static void
 do_addzones(RES* ssl, xfrd_state_type* xfrd)
 {
 	char buf[2048];
-	int num = 0;
+	int num = 0, applied = 0, r;
+	region_type* region = region_create(xalloc, free);
+	struct addzones_entry* list = NULL, **last = &list, *e;
 	while(ssl_read_line(ssl, buf, sizeof(buf))) {
+		char* arg2 = NULL;
 		if(buf[0] == 0x04 && buf[1] == 0)
 			break; /* end of transmission */
-		if(!perform_addzone(ssl, xfrd, buf)) {
+		if(!find_arg2(ssl, buf, &arg2)
+			|| (r = addzone_check(ssl, xfrd, buf, arg2)) == 0) {
 			if(!ssl_printf(ssl, "error for input line '%s'\n", 
-				buf))
+				buf)) {
+				region_destroy(region);
 				return;
-		} else {
-			if(!ssl_printf(ssl, "added: %s\n", buf))
+			}
+			continue;
+		}
+		if(r == -1) {
+			/* already exists, reported like the added zones */
+			if(!ssl_printf(ssl, "added: %s\n", buf)) {
+				region_destroy(region);
 				return;
+			}
 			num++;
+			continue;
 		}
+		e = (struct addzones_entry*)region_alloc(region, sizeof(*e));
+		e->next = NULL;
+		e->name = region_strdup(region, buf);
+		e->pattern = region_strdup(region, arg2);
+		*last = e;
+		last = &e->next;
+	}
+	zone_list_batch_start(xfrd->nsd->options);
+	for(e = list; e; e = e->next) {
+		/* a zone that is twice in the input, exists the second time */
+		const dname_type* dname = dname_parse(region, e->name);
+		if(dname && zone_options_find(xfrd->nsd->options, dname)) {
+			(void)ssl_printf(ssl, "zone %s already exists\n",
+				e->name);
+		} else if(!addzone_apply(ssl, xfrd, e->name, e->pattern)) {
+			if(!ssl_printf(ssl, "error for input line '%s'\n", 
+				e->name))
+				break;
+			continue;
+		} else {
+			applied++;
+		}
+		if(!ssl_printf(ssl, "added: %s\n", e->name))
+			break;
+		num++;
+	}
+	zone_list_batch_end(xfrd->nsd->options);
+	region_destroy(region);
+	/* the zones that are applied are loaded, also if the report to
+	 * the client has failed */
+	if(applied != 0) {
+		zonestat_inc_ifneeded(xfrd);
+		xfrd_set_reload_now(xfrd);
 	}
 	(void)ssl_printf(ssl, "added %d zones\n", num);
 }
@@ -1582,19 +1658,22 @@ do_delzones(RES* ssl, xfrd_state_type* xfrd)
 {
 	char buf[2048];
 	int num = 0;
+	zone_list_batch_start(xfrd->nsd->options);
 	while(ssl_read_line(ssl, buf, sizeof(buf))) {
 		if(buf[0] == 0x04 && buf[1] == 0)
 			break; /* end of transmission */
 		if(!perform_delzone(ssl, xfrd, buf)) {
 			if(!ssl_printf(ssl, "error for input line '%s'\n", 
 				buf))
-				return;
+				break;
 		} else {
 			if(!ssl_printf(ssl, "removed: %s\n", buf))
-				return;
+				break;
 			num++;
 		}
 	}
+	/* compact the zonelist once, for all the deleted zones */
+	zone_list_batch_end(xfrd->nsd->options);
 	(void)ssl_printf(ssl, "deleted %d zones\n", num);
 }
 
@@ -1778,7 +1857,12 @@ repat_interrupt_zones(xfrd_state_type* xfrd, struct nsd_options* newopt)
 			} else if(xz->zone_handler.ev_fd != -1) {
 				xfrd_udp_release(xz);
 				xfrd_set_refresh_now(xz);
+			} else if(xz->probes) {
+				/* the probes point at the old primaries */
+				xfrd_probe_stop(xz);
+				xfrd_set_refresh_now(xz);
 			}
+			xfrd_clear_master_rtt(xz);
 			xz->master = 0;
 			xz->master_num = 0;
 			xz->next_master = -1;
@@ -2085,6 +2169,71 @@ do_serverpid(RES* ssl, xfrd_state_type* xfrd)
 	(void)ssl_printf(ssl, "%u\n", (unsigned)xfrd->reload_pid);
 }
 
+/** do the xfrd_status command: printout the queues of xfrd */
+static void
+do_xfrd_status(RES* ssl, xfrd_state_type* xfrd)
+{
+	xfrd_zone_type* zone;
+	struct notify_zone* nz;
+	size_t num_ok = 0, num_refreshing = 0, num_expired = 0;
+	size_t num_activated = 0, num_udp_waiting = 0, num_tcp_waiting = 0;
+	size_t num_notify_waiting = 0;
+	RBTREE_FOR(zone, xfrd_zone_type*, xfrd->zones) {
+		if(zone->state == xfrd_zone_ok)
+			num_ok++;
+		else if(zone->state == xfrd_zone_refreshing)
+			num_refreshing++;
+		else	num_expired++;
+	}
+	for(zone = xfrd->activated_first; zone; zone = zone->activated_next)
+		num_activated++;
+	for(zone = xfrd->udp_waiting_first; zone;
+		zone = zone->udp_waiting_next)
+		num_udp_waiting++;
+	for(zone = xfrd->tcp_set->tcp_waiting_first; zone;
+		zone = zone->tcp_waiting_next)
+		num_tcp_waiting++;
+	for(nz = xfrd->notify_waiting_first; nz; nz = nz->waiting_next)
+		num_notify_waiting++;
+	if(!ssl_printf(ssl, "zones: %u\n", (unsigned)xfrd->zones->count))
+		return;
+	if(!ssl_printf(ssl, "zones.ok: %u\n", (unsigned)num_ok))
+		return;
+	if(!ssl_printf(ssl, "zones.refreshing: %u\n",
+		(unsigned)num_refreshing))
+		return;
+	if(!ssl_printf(ssl, "zones.expired: %u\n", (unsigned)num_expired))
+		return;
+	if(!ssl_printf(ssl, "activated: %u\n", (unsigned)num_activated))
+		return;
+	if(!ssl_printf(ssl, "deferred: %d\n", xfrd->request_deferred_num))
+		return;
+	if(!ssl_printf(ssl, "probes: %d\n", xfrd->probe_udp_num))
+		return;
+	if(!ssl_printf(ssl, "udp.active: %u\n", (unsigned)xfrd->udp_use_num))
+		return;
+	if(!ssl_printf(ssl, "udp.waiting: %u\n", (unsigned)num_udp_waiting))
+		return;
+	if(!ssl_printf(ssl, "tcp.active: %d\n", xfrd->tcp_set->tcp_count))
+		return;
+	if(!ssl_printf(ssl, "tcp.waiting: %u\n", (unsigned)num_tcp_waiting))
+		return;
+	if(!ssl_printf(ssl, "notify.active: %d\n", xfrd->notify_udp_num))
+		return;
+	if(!ssl_printf(ssl, "notify.waiting: %u\n",
+		(unsigned)num_notify_waiting))
+		return;
+	if(!ssl_printf(ssl, "notify.time.p50: %llu\n", (unsigned long long)
+		notify_time_percentile(xfrd, 50)))
+		return;
+	if(!ssl_printf(ssl, "notify.time.p90: %llu\n", (unsigned long long)
+		notify_time_percentile(xfrd, 90)))
+		return;
+	if(!ssl_printf(ssl, "notify.time.p99: %llu\n", (unsigned long long)
+		notify_time_percentile(xfrd, 99)))
+		return;
+}
+
 /** do the print_tsig command: printout tsig info */
 static void
 do_print_tsig(RES* ssl, xfrd_state_type* xfrd, char* arg)
@@ -2540,6 +2689,8 @@ execute_cmd(struct daemon_remote* rc, RES* ssl, char* cmd)
 		do_repattern(ssl, rc->xfrd);
 	} else if(cmdcmp(p, "reconfig", 8)) {
 		do_repattern(ssl, rc->xfrd);
+	} else if(cmdcmp(p, "xfrd_status", 11)) {
+		do_xfrd_status(ssl, rc->xfrd);
 	} else if(cmdcmp(p, "serverpid", 9)) {
 		do_serverpid(ssl, rc->xfrd);
 	} else if(cmdcmp(p, "print_tsig", 10)) {
@@ -2866,6 +3017,14 @@ print_stat_block(RES* ssl, char* n, char* d, struct nsdst* st)
 	if(!ssl_printf(ssl, "%s%snum.rixfr=%lu\n", n, d, (unsigned long)st->rixfr))
 		return;
 
+	/* NSEC3 hashes computed for queries and found in the cache */
+	if(!ssl_printf(ssl, "%s%snum.nsec3hash=%lu\n", n, d,
+		(unsigned long)st->nsec3hash))
+		return;
+	if(!ssl_printf(ssl, "%s%snum.nsec3cache=%lu\n", n, d,
+		(unsigned long)st->nsec3cache))
+		return;
+
 	/* truncated */
 	if(!ssl_printf(ssl, "%s%snum.truncated=%lu\n", n, d,
 		(unsigned long)st->truncated))
@@ -2976,6 +3135,10 @@ print_stats(RES* ssl, xfrd_state_type* xfrd, struct timeval* now, int clear,
 		return;
 	if(!print_longnum(ssl, "size.db.mem=", st->db_mem))
 		return;
+	if(!print_longnum(ssl, "size.db.mem.unused=", st->db_mem_unused))
+		return;
+	if(!print_longnum(ssl, "size.db.mem.recycle=", st->db_mem_recycle))
+		return;
 	if(!print_longnum(ssl, "size.xfrd.mem=", region_get_mem(xfrd->region)))
 		return;
 	if(!print_longnum(ssl, "size.config.disk=", 
@@ -3046,6 +3209,8 @@ process_stats_add_old_new(xfrd_state_type* xfrd, struct nsdst* stats)
 	size_t i;
 	uint64_t dbd = stats[0].db_disk;
 	uint64_t dbm = stats[0].db_mem;
+	uint64_t dbu = stats[0].db_mem_unused;
+	uint64_t dbr = stats[0].db_mem_recycle;
 	/* The old and new server processes have separate stat blocks,
 	 * and these are added up together. This results in the statistics
 	 * values per server-child. The reload task briefly forks both
@@ -3055,6 +3220,8 @@ process_stats_add_old_new(xfrd_state_type* xfrd, struct nsdst* stats)
 	}
 	stats[0].db_disk = dbd;
 	stats[0].db_mem = dbm;
+	stats[0].db_mem_unused = dbu;
+	stats[0].db_mem_recycle = dbr;
 }
 
 /* manage clearing of stats, a cumulative count of cleared statistics */
@@ -499,6 +499,7 @@ restart_child_servers(struct nsd *nsd, region_type* region, netio_type* netio,
 				nsd->server_kind = nsd->children[i].kind;
 				nsd->this_child = &nsd->children[i];
 				nsd->this_child->child_num = i;
+				nsd->this_child->pid = getpid();
 				/* remove signal flags inherited from parent
 				   the parent will handle them. */
 				nsd->signal_hint_reload_hup = 0;
@@ -534,6 +535,17 @@ static void set_bind8_alarm(struct nsd* nsd)
 	if(nsd->st_period > 0) /* % by 0 gives divbyzero error */
 		alarm(nsd->st_period - (time(NULL) % nsd->st_period));
 }
+
+/* the memory use of the database, in the first stat block, where
+ * nsd-control stats reads it */
+static void set_db_mem_stats(struct nsd* nsd)
+{
+	nsd->stat_map[0].db_mem = region_get_mem(nsd->db->region);
+	nsd->stat_map[0].db_mem_unused = region_get_mem_unused(
+		nsd->db->region);
+	nsd->stat_map[0].db_mem_recycle = region_get_recycle_size(
+		nsd->db->region);
+}
 #endif
 
 /* set zone stat ids for zones initially read in */
@@ -2324,14 +2336,17 @@ struct quit_sync_event_data {
 };
 
 static void server_reload_handle_sigchld(int sig, short event,
-		void* ATTR_UNUSED(arg))
+		void* arg)
 {
+	struct nsd* nsd = (struct nsd*)arg;
+	pid_t pid;
+	int status;
 	assert(sig == SIGCHLD);
 	assert(event & EV_SIGNAL);
 
-	/* reap the exited old-serve child(s) */
-	while(waitpid(-1, NULL, WNOHANG) > 0) {
-		/* pass */
+	/* reap the exited old-serve child(s), and zonefile writers */
+	while((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+		(void)namedb_zonefile_writer_exited(nsd, pid, status);
 	}
 }
 
@@ -2419,7 +2434,19 @@ server_reload(struct nsd *nsd, region_type* server_region, netio_type* netio,
 	/* see what tasks we got from xfrd */
 	task_remap(nsd->task[nsd->mytask]);
 	udb_ptr_init(&last_task, nsd->task[nsd->mytask]);
+	memset(&nsd->xfr_stats, 0, sizeof(nsd->xfr_stats));
 	reload_process_tasks(nsd, &last_task, cmdsocket);
+	task_process_prehash_pending(nsd);
+	if(nsd->xfr_stats.xfrs != 0) {
+		VERBOSITY(2, (LOG_INFO, "reload: applied %u transfers for %u "
+			"zones, apply %lld.%9.9ld sec, nsec3 prehash "
+			"%lld.%9.9ld sec", (unsigned)nsd->xfr_stats.xfrs,
+			(unsigned)nsd->xfr_stats.zones,
+			(long long)nsd->xfr_stats.apply_time.tv_sec,
+			(long)nsd->xfr_stats.apply_time.tv_nsec,
+			(long long)nsd->xfr_stats.prehash_time.tv_sec,
+			(long)nsd->xfr_stats.prehash_time.tv_nsec));
+	}
 
 #ifndef NDEBUG
 	if(nsd_debug_level >= 1)
@@ -2431,6 +2458,8 @@ server_reload(struct nsd *nsd, region_type* server_region, netio_type* netio,
 	/* Restart dumping stats if required.  */
 	time(&nsd->st->boot);
 	set_bind8_alarm(nsd);
+	/* the zone transfers changed the database memory */
+	set_db_mem_stats(nsd);
 	/* Switch to a different set of stat array for new server processes,
 	 * because they can briefly coexist with the old processes. They
 	 * have their own stat structure. */
@@ -2489,6 +2518,8 @@ server_reload(struct nsd *nsd, region_type* server_region, netio_type* netio,
 
 	/* listen for the signals of failed children again */
 	sigaction(SIGCHLD, &old_sigchld, NULL);
+	/* write the changed zonefiles, main reaps the writer */
+	namedb_write_zonefiles_start(nsd);
 #ifdef USE_DNSTAP
 	if (nsd->dt_collector) {
 		int *swap_fd_send;
@@ -2539,7 +2570,7 @@ server_reload(struct nsd *nsd, region_type* server_region, netio_type* netio,
 	cb_data.read = 0;
 
 	event_set(&signal_event, SIGCHLD, EV_SIGNAL|EV_PERSIST,
-	    server_reload_handle_sigchld, NULL);
+	    server_reload_handle_sigchld, nsd);
 	if(event_base_set(cb_data.base, &signal_event) != 0
 	|| signal_add(&signal_event, NULL) != 0) {
 		log_msg(LOG_ERR, "NSD quit sync: could not add signal event");
@@ -2661,7 +2692,7 @@ server_main(struct nsd *nsd)
 #ifdef BIND8_STATS
 	nsd->st = &nsd->stat_map[0];
 	nsd->st->db_disk = 0;
-	nsd->st->db_mem = region_get_mem(nsd->db->region);
+	set_db_mem_stats(nsd);
 #endif
 
 	/* Start the child processes that handle incoming queries */
@@ -2764,6 +2795,9 @@ server_main(struct nsd *nsd)
 						nsd->mode = NSD_RELOAD_REQ;
 					}
 #endif
+				} else if(namedb_zonefile_writer_exited(nsd,
+					child_pid, status)) {
+					/* failure logged, zones marked */
 				} else if(status != 0) {
 					/* check for status, because we get
 					 * the old-servermain because reload
@@ -3258,6 +3292,7 @@ static void server_verify(struct nsd *nsd, int cmdsocket,
 		nsd->verifiers[i].output_stream.priority = LOG_INFO;
 		nsd->verifiers[i].error_stream.fd = -1;
 		nsd->verifiers[i].error_stream.priority = LOG_ERR;
+		nsd->verifiers[i].zone_feed.fd = -1;
 	}
 
 	event_set(&cmd_event, cmdsocket, EV_READ|EV_PERSIST, verify_handle_command, nsd);
@@ -3374,6 +3409,10 @@ server_child(struct nsd *nsd)
 #ifdef RATELIMIT
 	rrl_init(nsd->this_child->child_num);
 #endif
+#ifdef NSEC3
+	nsd->nsec3_hash_cache = nsec3_hash_cache_create(server_region,
+		nsd->options->nsec3_hash_cache_size);
+#endif
 
 	assert(nsd->server_kind != NSD_SERVER_MAIN);
 
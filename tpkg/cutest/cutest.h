@@ -131,4 +131,8 @@ int CuSuiteRunRegexDisplay(CuSuite* testSuite, const char *regex, void (*callbac
 void CuSuiteSummary(CuSuite* testSuite, CuString* summary);
 void CuSuiteDetails(CuSuite* testSuite, CuString* details);
 
+/* Added for NSD: set by cutest -b, the suites register their speed
+   tests only if it is set, so the default run does not time anything. */
+extern int cutest_benchmarks;
+
 #endif /* CU_TEST_H */
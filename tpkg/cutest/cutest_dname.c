@@ -10,16 +10,24 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include "tpkg/cutest/cutest.h"
 #include "region-allocator.h"
 #include "dname.h"
+#include "radtree.h"
+#include "util.h"
 
 static void dname_1(CuTest *tc);
+static void dname_2(CuTest *tc);
+static void dname_query_speed(CuTest *tc);
 
 CuSuite* reg_cutest_dname(void)
 {
 	CuSuite* suite = CuSuiteNew();
 	SUITE_ADD_TEST(suite, dname_1);
+	SUITE_ADD_TEST(suite, dname_2);
+	if(cutest_benchmarks)
+		SUITE_ADD_TEST(suite, dname_query_speed);
 	return suite;
 }
 
@@ -205,3 +213,122 @@ dname_1(CuTest *tc)
 
 	region_destroy(region);
 }
+
+/* query names, like a mix of queries to an authoritative server */
+static const char* query_mix[] = {
+	"\003www\007example\003com\000",
+	"\007EXAMPLE\003com\000",
+	"\003wWw\007ExAmPlE\003CoM\000",
+	"\000",
+	"\004_tcp\005_ldap\002nl\000",
+	"\005mail1\004mail\007example\003org\000",
+	"\0010\0011\0012\0013\0014\0015\0016\0017\0018\0019\003ip6\004arpa\000",
+	"\0371234567890123456789012345678901\007example\003net\000",
+	NULL
+};
+
+/* check dname_make_in_buffer against dname_make */
+static void dname_2(CuTest *tc)
+{
+	region_type* region = region_create(xalloc, free);
+	uint8_t space[DNAME_MAX_SIZE];
+	uint8_t wire[MAXDOMAINLEN+2];
+	uint8_t key[MAXDOMAINLEN], radkey[MAXDOMAINLEN];
+	radstrlen_type radlen;
+	const dname_type* made;
+	size_t len, keylen;
+	int i;
+
+	for(i=0; query_mix[i]; i++) {
+		const uint8_t* name = (const uint8_t*)query_mix[i];
+		size_t wirelen = strlen(query_mix[i])+1;
+		len = dname_make_in_buffer(space, name, name+wirelen+4, key,
+			&keylen);
+		made = dname_make(region, name, 1);
+		CuAssert(tc, "in buffer length", len == wirelen);
+		CuAssert(tc, "in buffer dname", memcmp(space, made,
+			dname_total_size(made)) == 0);
+		radlen = (radstrlen_type)sizeof(radkey);
+		radname_d2r(radkey, &radlen, name, wirelen);
+		CuAssert(tc, "in buffer key length", keylen == radlen);
+		CuAssert(tc, "in buffer key", memcmp(key, radkey, radlen) == 0);
+		CuAssert(tc, "in buffer without key", dname_make_in_buffer(
+			space, name, name+wirelen, NULL, NULL) == wirelen);
+		/* the name must end before the end */
+		CuAssert(tc, "in buffer truncated", dname_make_in_buffer(space,
+			name, name+wirelen-1, key, &keylen) == 0);
+	}
+
+	/* compression pointers are not allowed */
+	CuAssert(tc, "in buffer pointer", dname_make_in_buffer(space,
+		(const uint8_t*)"\003www\300\014", (const uint8_t*)
+		"\003www\300\014"+6, NULL, NULL) == 0);
+
+	/* a name of 255 octets is allowed, a longer one is not */
+	memset(wire, 1, sizeof(wire));
+	for(i=0; i<254; i+=2)
+		wire[i] = 1;
+	wire[254] = 0;
+	CuAssert(tc, "in buffer longest", dname_make_in_buffer(space, wire,
+		wire+sizeof(wire), key, &keylen) == 255);
+	CuAssert(tc, "in buffer longest key", keylen == 253);
+	CuAssert(tc, "in buffer longest labels",
+		((dname_type*)space)->label_count == 128);
+	wire[254] = 1;
+	wire[255] = 'a';
+	wire[256] = 0;
+	CuAssert(tc, "in buffer too long", dname_make_in_buffer(space, wire,
+		wire+sizeof(wire), key, &keylen) == 0);
+
+	region_destroy(region);
+}
+
+/* query names parsed per second, run with -b -r dname_query_speed to see it */
+static void dname_query_speed(CuTest *tc)
+{
+	region_type* region = region_create(xalloc, free);
+	uint8_t space[DNAME_MAX_SIZE];
+	uint8_t qnamebuf[MAXDOMAINLEN], key[MAXDOMAINLEN];
+	size_t keylen;
+	struct timespec start, end;
+	double elapsed_copy, elapsed_buffer;
+	int i, j, count = 200000, num = 0, good = 0;
+
+	while(query_mix[num])
+		num++;
+
+	/* the query name copied out of the packet and made in the region */
+	get_time(&start);
+	for(i=0; i<count; i++) {
+		for(j=0; j<num; j++) {
+			const uint8_t* name = (const uint8_t*)query_mix[j];
+			memcpy(qnamebuf, name, strlen(query_mix[j])+1);
+			if(dname_make(region, qnamebuf, 1))
+				good++;
+		}
+		region_free_all(region);
+	}
+	get_time(&end);
+	timespec_subtract(&end, &start);
+	elapsed_copy = (double)end.tv_sec + (double)end.tv_nsec/1.0e9;
+
+	/* the query name and its radix key made in one pass without
+	 * allocation */
+	get_time(&start);
+	for(i=0; i<count; i++) {
+		for(j=0; j<num; j++) {
+			const uint8_t* name = (const uint8_t*)query_mix[j];
+			if(dname_make_in_buffer(space, name, name+MAXDOMAINLEN,
+				key, &keylen))
+				good++;
+		}
+	}
+	get_time(&end);
+	timespec_subtract(&end, &start);
+	elapsed_buffer = (double)end.tv_sec + (double)end.tv_nsec/1.0e9;
+
+	CuAssert(tc, "all names parsed", good == 2*count*num);
+	printf("query name: %d names, copy and region %g sec, "
+		"in buffer %g sec\n", count*num, elapsed_copy, elapsed_buffer);
+	region_destroy(region);
+}
@@ -13,14 +13,19 @@
 #include "tpkg/cutest/cutest.h"
 #include "region-allocator.h"
 #include "dns.h"
+#include "buffer.h"
+#include "namedb.h"
+#include "rdata.h"
 
 static void dns_1(CuTest *tc);
+static void dns_2(CuTest *tc);
 
 CuSuite* reg_cutest_dns(void)
 {
         CuSuite* suite = CuSuiteNew();
 
 	SUITE_ADD_TEST(suite, dns_1);
+	SUITE_ADD_TEST(suite, dns_2);
 	return suite;
 }
 
@@ -39,3 +44,60 @@ static void dns_1(CuTest *tc)
 	d = rrtype_descriptor_by_type(TYPE_NSEC3);
 	CuAssert(tc, "dns rrtype descriptor: type nsec3", d->type == TYPE_NSEC3);
 }
+
+/* convert the rdata to atoms, check they are in one block and marshal
+ * back to the same rdata */
+static void
+dns_rdata_check(CuTest *tc, region_type* region, domain_table_type* table,
+	uint16_t type, const char* wire, size_t len, size_t blocksize)
+{
+	buffer_type* packet = buffer_create(region, 1024);
+	uint8_t out[1024];
+	rr_type rr;
+	ssize_t i;
+
+	buffer_write(packet, wire, len);
+	buffer_flip(packet);
+	memset(&rr, 0, sizeof(rr));
+	rr.type = type;
+	rr.klass = CLASS_IN;
+	i = rdata_wireformat_to_rdata_atoms(region, table, type, len, packet,
+		&rr.rdatas);
+	CuAssert(tc, "rdata parsed", i > 0);
+	rr.rdata_count = i;
+	CuAssert(tc, "rdata block size", rdata_atoms_size(type, rr.rdatas,
+		rr.rdata_count) == blocksize);
+	for(i=0; i<rr.rdata_count; i++) {
+		uint8_t* p = (uint8_t*)rr.rdatas[i].data;
+		if(rdata_atom_is_domain(type, i))
+			continue;
+		CuAssert(tc, "rdata atom in block",
+			p >= (uint8_t*)(rr.rdatas + rr.rdata_count) &&
+			p + sizeof(uint16_t) + rdata_atom_size(rr.rdatas[i]) <=
+			(uint8_t*)rr.rdatas + blocksize);
+	}
+	CuAssert(tc, "rdata marshal", rr_marshal_rdata(&rr, out, sizeof(out))
+		== len && memcmp(out, wire, len) == 0);
+}
+
+static void dns_2(CuTest *tc)
+{
+	region_type* region = region_create(xalloc, free);
+	domain_table_type* table = domain_table_create(region);
+
+	/* a literal and a name */
+	dns_rdata_check(tc, region, table, TYPE_MX,
+		"\000\012\004mail\007example\003com\000", 20,
+		2*sizeof(rdata_atom_type) + 4);
+	/* odd sized text is padded */
+	dns_rdata_check(tc, region, table, TYPE_TXT,
+		"\005hello\003abc", 10, sizeof(rdata_atom_type) + 12);
+	/* the gateway name is stored as literal data */
+	dns_rdata_check(tc, region, table, TYPE_IPSECKEY,
+		"\012\003\002\002gw\007example\003com\000\001\002\003",
+		22, 5*sizeof(rdata_atom_type) + 3*4 + 18 + 6);
+	/* an address */
+	dns_rdata_check(tc, region, table, TYPE_A, "\300\000\002\001", 4,
+		sizeof(rdata_atom_type) + 6);
+	region_destroy(region);
+}
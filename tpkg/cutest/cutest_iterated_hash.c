@@ -10,6 +10,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <time.h>
 #include "tpkg/cutest/cutest.h"
 #include "region-allocator.h"
 #include "util.h"
@@ -17,12 +18,17 @@
 #include "dname.h"
 
 static void hash_1(CuTest *tc);
+static void hash_rfc5155(CuTest *tc);
+static void hash_speed(CuTest *tc);
 
 CuSuite* reg_cutest_iterated_hash(void)
 {
         CuSuite* suite = CuSuiteNew();
 
 	SUITE_ADD_TEST(suite, hash_1);
+	SUITE_ADD_TEST(suite, hash_rfc5155);
+	if(cutest_benchmarks)
+		SUITE_ADD_TEST(suite, hash_speed);
 	return suite;
 }
 
@@ -51,3 +57,61 @@ static void hash_1(CuTest *tc)
 	(void)tc;
 #endif /* NSEC3 */
 }
+
+static void hash_rfc5155(CuTest *tc)
+{
+#ifdef NSEC3
+	/* hashes from the example zone in RFC 5155 appendix A,
+	 * salt aabbccdd and 12 iterations. The context is reused between
+	 * calls, check that the result does not depend on the call before */
+	unsigned char out[SHA_DIGEST_LENGTH];
+	unsigned char salt[4] = {0xaa, 0xbb, 0xcc, 0xdd};
+	char b32[SHA_DIGEST_LENGTH*2+1];
+	int i;
+	for(i=0; i<2; i++) {
+		CuAssert(tc, "hash example", sizeof(out) == iterated_hash(
+			out, salt, sizeof(salt), (unsigned char*)
+			"\007example\000", 9, 12));
+		b32_ntop(out, sizeof(out), b32, sizeof(b32));
+		CuAssertStrEquals(tc, "0p9mhaveqvm6t7vbl5lop2u3t2rp3tom", b32);
+		CuAssert(tc, "hash a.example", sizeof(out) == iterated_hash(
+			out, salt, sizeof(salt), (unsigned char*)
+			"\001a\007example\000", 11, 12));
+		b32_ntop(out, sizeof(out), b32, sizeof(b32));
+		CuAssertStrEquals(tc, "35mthgpgcu1qg68fab165klnsnk3dpvl", b32);
+	}
+#else
+	(void)tc;
+#endif /* NSEC3 */
+}
+
+/* hashes per second, run with -b -r hash_speed to see the output */
+static void hash_speed(CuTest *tc)
+{
+#ifdef NSEC3
+	unsigned char out[SHA_DIGEST_LENGTH];
+	unsigned char salt[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+	unsigned char wire[64];
+	struct timespec start, end;
+	double elapsed;
+	int i, count = 100000, iterations = 10;
+
+	get_time(&start);
+	for(i=0; i<count; i++) {
+		/* the name www<i>.example.com in wire format */
+		int len = snprintf((char*)wire+1, sizeof(wire)-1, "www%d", i);
+		wire[0] = (unsigned char)len;
+		memcpy(wire+1+len, "\007example\003com\000", 13);
+		CuAssert(tc, "iterated_hash speed", sizeof(out) == iterated_hash(
+			out, salt, sizeof(salt), wire, len+1+13, iterations));
+	}
+	get_time(&end);
+	timespec_subtract(&end, &start);
+	elapsed = (double)end.tv_sec + (double)end.tv_nsec/1.0e9;
+	printf("iterated_hash: %d names, %d iterations, %g sec, %g names/sec\n",
+		count, iterations, elapsed,
+		(elapsed>0?(double)count/elapsed:0.0));
+#else
+	(void)tc;
+#endif /* NSEC3 */
+}
@@ -451,28 +451,22 @@ usage_for_rrsets(rrset_type* list, size_t* usage)
 static void
 check_numlist(CuTest* tc, domain_table_type* table)
 {
-	domain_type* d = table->root, *prevd = NULL;
-	size_t num = 1;
+	domain_type* d = table->root;
+	size_t num;
 	/* first is root at number 1 */
 	CuAssertTrue(tc, d != NULL);
-	CuAssertTrue(tc, d->number == num);
+	CuAssertTrue(tc, d->number == 1);
+	CuAssertTrue(tc, table->numlist[1] == d);
 	CuAssertTrue(tc, domain_dname(d)->label_count == 1);
-	while(d) {
+	CuAssertTrue(tc, table->numlist_count < table->numlist_size);
+	for(num = 1; num <= table->numlist_count; num++) {
 		/* check number */
+		d = table->numlist[num];
+		CuAssertTrue(tc, d != NULL);
 		CuAssertTrue(tc, d->number == num);
-		/* check list structure */
-		CuAssertTrue(tc, d->numlist_prev == prevd);
-		if(d->numlist_next) {
-			CuAssertTrue(tc, d == d->numlist_next->numlist_prev);
-		} else {
-			CuAssertTrue(tc, d == table->numlist_last);
-		}
-
-		num++;
-		prevd = d;
-		d = d->numlist_next;
 	}
-	CuAssertTrue(tc, table->numlist_last->number == domain_table_count(table));
+	CuAssertTrue(tc, domain_table_numlist_last(table)->number ==
+		domain_table_count(table));
 }
 
 /* walk domains and check them */
@@ -17,6 +17,7 @@
 #include "util.h"
 #include "dname.h"
 #include "nsd.h"
+#include "query.h"
 
 static void acl_1(CuTest *tc);
 static void acl_2(CuTest *tc);
@@ -24,9 +25,12 @@ static void acl_3(CuTest *tc);
 static void acl_4(CuTest *tc);
 static void acl_5(CuTest *tc);
 static void acl_6(CuTest *tc);
+static void acl_7(CuTest *tc);
+static void acl_speed(CuTest *tc);
 static void replace_1(CuTest *tc);
 static void replace_2(CuTest *tc);
 static void zonelist_1(CuTest *tc);
+static void zonehash_1(CuTest *tc);
 
 CuSuite* reg_cutest_options(void)
 {
@@ -38,9 +42,13 @@ CuSuite* reg_cutest_options(void)
 	SUITE_ADD_TEST(suite, acl_4); /* parse_acl_range_type */
 	SUITE_ADD_TEST(suite, acl_5); /* parse_acl_range_subnet */
 	SUITE_ADD_TEST(suite, acl_6); /* acl_same_host */
+	SUITE_ADD_TEST(suite, acl_7); /* acl_list_compile */
+	if(cutest_benchmarks)
+		SUITE_ADD_TEST(suite, acl_speed);
 	SUITE_ADD_TEST(suite, replace_1); /* replace_str */
 	SUITE_ADD_TEST(suite, replace_2); /* make_zonefile */
 	SUITE_ADD_TEST(suite, zonelist_1); /* zonelist */
+	SUITE_ADD_TEST(suite, zonehash_1); /* zone_options_find */
 	return suite;
 }
 
@@ -399,6 +407,191 @@ check_zonelist_file(CuTest *tc, struct nsd_options* opt, const char* s)
 	fclose(in);
 }
 
+/* check the acl list element by element, like acl_check_incoming */
+static int
+acl_check_walk(struct acl_options* acl, struct query* q,
+	struct acl_options** reason)
+{
+	struct acl_options* match = NULL;
+	int number = 0, found = -1;
+	for(; acl; acl = acl->next, number++) {
+		if(!acl_addr_matches(acl, q) || !acl_key_matches(acl, q))
+			continue;
+		if(!match) {
+			match = acl;
+			found = number;
+		}
+		if(acl->blocked) {
+			*reason = acl;
+			return -1;
+		}
+	}
+	*reason = match;
+	return found;
+}
+
+/* make a random acl element for addresses in 10.0.0.0/16 */
+static struct acl_options*
+acl_random(region_type* region)
+{
+	char spec[128];
+	int a = random()%256, b = random()%256, c = random()%256;
+	switch(random()%6) {
+	case 0:
+		snprintf(spec, sizeof(spec), "10.0.%d.%d", a, b);
+		break;
+	case 1:
+		snprintf(spec, sizeof(spec), "10.0.%d.0/%d", a,
+			(int)(16+random()%17));
+		break;
+	case 2:
+		snprintf(spec, sizeof(spec), "10.0.%d.0&255.255.255.0", a);
+		break;
+	case 3:
+		/* not a prefix */
+		snprintf(spec, sizeof(spec), "10.0.0.%d&255.255.0.255", b);
+		break;
+	case 4:
+		snprintf(spec, sizeof(spec), "10.0.%d.%d-10.0.%d.%d",
+			a, b, (a<c?c:a), c);
+		break;
+	default:
+		snprintf(spec, sizeof(spec), "10.0.%d.%d@53", a, b);
+		break;
+	}
+	return parse_acl_info(region, region_strdup(region, spec),
+		(random()%8==0)?"BLOCKED":"NOKEY");
+}
+
+static void acl_7(CuTest *tc)
+{
+	/* acl_list_compile, the trie lookup gives the same result as
+	 * checking the list element by element */
+	region_type* region = region_create(xalloc, free);
+	struct acl_options* list = NULL, *last = NULL, *acl;
+	struct acl_options* r1, *r2;
+	struct query q;
+	struct sockaddr_in* sin = (struct sockaddr_in*)&q.client_addr;
+	int i;
+
+	for(i=0; i<300; i++) {
+		acl = acl_random(region);
+		if(last) last->next = acl;
+		else list = acl;
+		last = acl;
+	}
+	CuAssert(tc, "check acl_list_compile", acl_list_compile(list));
+	CuAssert(tc, "check acl_list_compile trie", list->trie != NULL);
+
+	memset(&q, 0, sizeof(q));
+	q.tsig.status = TSIG_NOT_PRESENT;
+	for(i=0; i<100000; i++) {
+		sin->sin_family = AF_INET;
+		sin->sin_port = htons((random()%2)?53:5353);
+		sin->sin_addr.s_addr = htonl(0x0a000000 | (random()&0xffff));
+		CuAssert(tc, "check acl trie lookup",
+			acl_check_incoming(list, &q, &r1) ==
+			acl_check_walk(list, &q, &r2));
+		CuAssert(tc, "check acl trie reason", r1 == r2);
+	}
+	/* other address family, no matches */
+	((struct sockaddr*)&q.client_addr)->sa_family = AF_UNSPEC;
+	CuAssert(tc, "check acl trie family",
+		acl_check_incoming(list, &q, &r1) == -1 && r1 == NULL);
+
+	/* short lists are not compiled */
+	CuAssert(tc, "check acl_list_compile short",
+		!acl_list_compile(acl_random(region)));
+	region_destroy(region);
+}
+
+/* make a random acl element that is an address or a subnet, like the
+ * lists of primaries and secondaries, in 10.0.0.0/16 */
+static struct acl_options*
+acl_random_prefix(region_type* region)
+{
+	char spec[128];
+	int a = random()%256, b = random()%256;
+	if(random()%4 == 0)
+		snprintf(spec, sizeof(spec), "10.0.%d.0/%d", a,
+			(int)(24+random()%9));
+	else	snprintf(spec, sizeof(spec), "10.0.%d.%d", a, b);
+	return parse_acl_info(region, region_strdup(region, spec),
+		(random()%8==0)?"BLOCKED":"NOKEY");
+}
+
+/* time count lookups in the list, with the trie or the list walk,
+ * returns the number of matches */
+static int
+acl_speed_run(struct acl_options* list, struct query* q, uint32_t* addrs,
+	int count, int trie, double* elapsed)
+{
+	struct sockaddr_in* sin = (struct sockaddr_in*)&q->client_addr;
+	struct acl_options* reason;
+	struct timespec start, end;
+	int i, found = 0;
+	get_time(&start);
+	for(i=0; i<count; i++) {
+		sin->sin_addr.s_addr = addrs[i];
+		if(trie)
+			found += (acl_check_incoming(list, q, &reason) != -1);
+		else	found += (acl_check_walk(list, q, &reason) != -1);
+	}
+	get_time(&end);
+	timespec_subtract(&end, &start);
+	*elapsed = (double)end.tv_sec + (double)end.tv_nsec/1.0e9;
+	return found;
+}
+
+/* ACL lookups per second with the trie and with the list walk, for lists
+ * of increasing length of addresses and subnets, and for lists that also
+ * have ranges, run with -b -r acl_speed to see it */
+static void acl_speed(CuTest *tc)
+{
+	int sizes[] = {10, 30, 100, 1000, 10000};
+	int count = 200000, s, i, mixed;
+	uint32_t* addrs = (uint32_t*)xalloc_array_zero(count,
+		sizeof(uint32_t));
+	struct query q;
+	struct sockaddr_in* sin = (struct sockaddr_in*)&q.client_addr;
+
+	memset(&q, 0, sizeof(q));
+	q.tsig.status = TSIG_NOT_PRESENT;
+	sin->sin_family = AF_INET;
+	sin->sin_port = htons(53);
+	for(i=0; i<count; i++)
+		addrs[i] = htonl(0x0a000000 | (random()&0xffff));
+
+	for(mixed=0; mixed<2; mixed++)
+	for(s=0; s<(int)(sizeof(sizes)/sizeof(sizes[0])); s++) {
+		region_type* region = region_create(xalloc, free);
+		struct acl_options* list = NULL, *last = NULL, *acl;
+		double t_trie, t_walk;
+		int f_trie, f_walk;
+		for(i=0; i<sizes[s]; i++) {
+			acl = mixed?acl_random(region):
+				acl_random_prefix(region);
+			if(last) last->next = acl;
+			else list = acl;
+			last = acl;
+		}
+		/* the first lookup compiles the trie */
+		f_walk = acl_speed_run(list, &q, addrs, count, 0, &t_walk);
+		f_trie = acl_speed_run(list, &q, addrs, count, 1, &t_trie);
+		CuAssert(tc, "same matches with trie and walk",
+			f_trie == f_walk);
+		/* short lists are not compiled, and are walked by
+		 * acl_check_incoming */
+		printf("acl %d %s elements: walk %g lookups/sec, %s %g "
+			"lookups/sec\n", sizes[s], (mixed?"mixed":"prefix"),
+			(t_walk>0?(double)count/t_walk:0.0),
+			(list->trie?"trie":"incoming"),
+			(t_trie>0?(double)count/t_trie:0.0));
+		region_destroy(region);
+	}
+	free(addrs);
+}
+
 static void zonelist_1(CuTest *tc)
 {
 	struct zone_options* z1, *z2, *z3;
@@ -507,3 +700,49 @@ static void zonelist_1(CuTest *tc)
 	region_destroy(region);
 	unlink(zname);
 }
+
+/* the zone hash table finds the same zones as the rbtree */
+static void zonehash_1(CuTest *tc)
+{
+#define ZONEHASH_NUM 1000
+	struct zone_options* zones[ZONEHASH_NUM];
+	char nm[64];
+	const dname_type* dname;
+	int i;
+	region_type* region = region_create(xalloc, free);
+	struct nsd_options* opt = nsd_options_create(region);
+	opt->region = region;
+
+	CuAssertTrue(tc, zone_options_find(opt, dname_parse(region,
+		"example.com")) == NULL);
+	for(i=0; i<ZONEHASH_NUM; i++) {
+		snprintf(nm, sizeof(nm), "zone%d.example.com", i);
+		zones[i] = zone_options_create(region);
+		zones[i]->name = region_strdup(region, nm);
+		CuAssertTrue(tc, nsd_options_insert_zone(opt, zones[i]));
+	}
+	for(i=0; i<ZONEHASH_NUM; i++) {
+		/* lookups are case insensitive */
+		snprintf(nm, sizeof(nm), "ZONE%d.Example.COM", i);
+		dname = dname_parse(region, nm);
+		CuAssertTrue(tc, zone_options_find(opt, dname) == zones[i]);
+		CuAssertTrue(tc, zone_options_find(opt, dname) ==
+			(struct zone_options*)rbtree_search(opt->zone_options,
+			dname));
+	}
+	/* delete every other zone, the rest must still be found */
+	for(i=0; i<ZONEHASH_NUM; i+=2)
+		zone_options_delete(opt, zones[i]);
+	for(i=0; i<ZONEHASH_NUM; i++) {
+		snprintf(nm, sizeof(nm), "zone%d.example.com", i);
+		dname = dname_parse(region, nm);
+		if(i%2 == 0)
+			CuAssertTrue(tc, zone_options_find(opt, dname) == NULL);
+		else	CuAssertTrue(tc, zone_options_find(opt, dname) ==
+				zones[i]);
+	}
+	CuAssertTrue(tc, zone_options_find(opt, dname_parse(region,
+		"zone1.example.net")) == NULL);
+	region_destroy(region);
+#undef ZONEHASH_NUM
+}
@@ -20,6 +20,7 @@ CuSuite * reg_cutest_util(void);
 CuSuite * reg_cutest_options(void);
 CuSuite * reg_cutest_dns(void);
 CuSuite * reg_cutest_iterated_hash(void);
+CuSuite * reg_cutest_tsig(void);
 CuSuite * reg_cutest_dname(void);
 CuSuite * reg_cutest_region(void);
 CuSuite * reg_cutest_udb(void);
@@ -32,6 +33,9 @@ CuSuite * reg_cutest_popen3(void);
 CuSuite * reg_cutest_iter(void);
 CuSuite * reg_cutest_event(void);
 
+/* register the speed tests too, set by -b */
+int cutest_benchmarks = 0;
+
 /* dummy functions to link */
 struct nsd nsd;
 int writepid(struct nsd * ATTR_UNUSED(nsd))
@@ -72,6 +76,7 @@ int runalltests(const char *regex)
 	CuSuiteAddSuite(suite, reg_cutest_rbtree());
 	CuSuiteAddSuite(suite, reg_cutest_util());
 	CuSuiteAddSuite(suite, reg_cutest_iterated_hash());
+	CuSuiteAddSuite(suite, reg_cutest_tsig());
 #ifdef HAVE_MMAP
 	CuSuiteAddSuite(suite, reg_cutest_udb());
 #endif
@@ -130,10 +135,13 @@ int main(int argc, char* argv[])
 	unsigned seed;
 	char *regex = ".*";
 	log_init("cutest");
-	while((c = getopt(argc, argv, "c:hq:r:tv")) != -1) {
+	while((c = getopt(argc, argv, "bc:hq:r:tv")) != -1) {
 		switch(c) {
 		case 't':
 			return check_inet_ntop();
+		case 'b':
+			cutest_benchmarks = 1;
+			break;
 		case 'c':
 			config = optarg;
 			break;
@@ -155,6 +163,7 @@ int main(int argc, char* argv[])
 			printf("-t test inet_ntop for string comparisons.\n");
 			printf("-v verbose, -vv, -vvv\n");
 			printf("-r regex: run only tests that match regex.\n");
+			printf("-b also run the speed tests, that print timings.\n");
 			printf("-h show help\n");
 			return 1;
 		}
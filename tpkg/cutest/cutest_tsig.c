@@ -0,0 +1,175 @@
+/*
+	test tsig.h
+*/
+
+#include "config.h"
+
+#ifdef HAVE_STRING_H
+#include <string.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "tpkg/cutest/cutest.h"
+#include "region-allocator.h"
+#include "util.h"
+#include "buffer.h"
+#include "packet.h"
+#include "tsig.h"
+
+static void tsig_1(CuTest *tc);
+static void tsig_speed(CuTest *tc);
+
+CuSuite* reg_cutest_tsig(void)
+{
+        CuSuite* suite = CuSuiteNew();
+
+	SUITE_ADD_TEST(suite, tsig_1);
+	if(cutest_benchmarks)
+		SUITE_ADD_TEST(suite, tsig_speed);
+	return suite;
+}
+
+#ifdef HAVE_SSL
+/* make a TSIG signed query for www.example.com A in the packet */
+static void
+tsig_sign_query(tsig_record_type* tsig, buffer_type* packet,
+	tsig_algorithm_type* algo, tsig_key_type* key, uint16_t id)
+{
+	buffer_clear(packet);
+	buffer_write_u16(packet, id);
+	buffer_write_u16(packet, 0); /* flags */
+	buffer_write_u16(packet, 1); /* qdcount */
+	buffer_write_u16(packet, 0);
+	buffer_write_u16(packet, 0);
+	buffer_write_u16(packet, 0); /* arcount */
+	buffer_write(packet, "\003www\007example\003com\000", 17);
+	buffer_write_u16(packet, TYPE_A);
+	buffer_write_u16(packet, CLASS_IN);
+
+	tsig_init_record(tsig, algo, key);
+	tsig_init_query(tsig, id);
+	tsig_prepare(tsig);
+	tsig_update(tsig, packet, buffer_position(packet));
+	tsig_sign(tsig);
+	tsig_append_rr(tsig, packet);
+	ARCOUNT_SET(packet, 1);
+	buffer_flip(packet);
+}
+
+/* verify the query like process_tsig does, returns true if good */
+static int
+tsig_verify_query(tsig_record_type* tsig, buffer_type* packet)
+{
+	tsig_init_record(tsig, NULL, NULL);
+	if(!tsig_find_rr(tsig, packet) || tsig->status != TSIG_OK)
+		return 0;
+	if(!tsig_from_query(tsig))
+		return 0;
+	buffer_set_limit(packet, tsig->position);
+	ARCOUNT_SET(packet, ARCOUNT(packet) - 1);
+	tsig_prepare(tsig);
+	tsig_update(tsig, packet, buffer_limit(packet));
+	return tsig_verify(tsig);
+}
+
+/* set up the tsig module with key 'test.key.' for hmac-sha256 */
+static tsig_key_type*
+tsig_test_setup(region_type* region, tsig_algorithm_type** algo)
+{
+	tsig_key_type* key = region_alloc_zero(region, sizeof(*key));
+	tsig_init(region);
+	*algo = tsig_get_algorithm_by_name("hmac-sha256");
+	key->name = dname_parse(region, "test.key.");
+	key->size = 32;
+	key->data = region_alloc(region, key->size);
+	memset(key->data, 0x42, key->size);
+	tsig_add_key(key);
+	return key;
+}
+#endif /* HAVE_SSL */
+
+/* sign and verify with the keyed HMAC state in the key */
+static void tsig_1(CuTest *tc)
+{
+#ifdef HAVE_SSL
+	region_type* region = region_create(xalloc, free);
+	buffer_type* packet = buffer_create(region, 1024);
+	tsig_record_type signer, verifier;
+	tsig_algorithm_type* algo;
+	tsig_key_type* key = tsig_test_setup(region, &algo);
+	int i;
+
+	CuAssert(tc, "hmac-sha256 algorithm", algo != NULL);
+	tsig_create_record(&signer, region);
+	tsig_create_record(&verifier, region);
+	for(i=0; i<3; i++) {
+		tsig_sign_query(&signer, packet, algo, key, 1000+i);
+		CuAssert(tc, "verify tsig", tsig_verify_query(&verifier,
+			packet));
+		CuAssert(tc, "keyed state", key->state != NULL &&
+			key->state_algorithm == algo);
+	}
+
+	/* a changed secret must not use the old keyed state */
+	tsig_sign_query(&signer, packet, algo, key, 2000);
+	tsig_key_clear_state(key);
+	CuAssert(tc, "state cleared", key->state == NULL);
+	key->data[0] = 0x43;
+	CuAssert(tc, "verify fails after key change",
+		!tsig_verify_query(&verifier, packet));
+	tsig_sign_query(&signer, packet, algo, key, 2001);
+	CuAssert(tc, "verify with the new key", tsig_verify_query(&verifier,
+		packet));
+
+	tsig_key_clear_state(key);
+	tsig_del_key(key);
+	region_destroy(region);
+#else
+	(void)tc;
+#endif /* HAVE_SSL */
+}
+
+/* verified TSIG queries per second, run with -b -r tsig_speed to see it */
+static void tsig_speed(CuTest *tc)
+{
+#ifdef HAVE_SSL
+	region_type* region = region_create(xalloc, free);
+	buffer_type* packet = buffer_create(region, 1024);
+	uint8_t wire[1024];
+	size_t len;
+	tsig_record_type signer, verifier;
+	tsig_algorithm_type* algo;
+	tsig_key_type* key = tsig_test_setup(region, &algo);
+	struct timespec start, end;
+	double elapsed;
+	int i, count = 100000, good = 0;
+
+	tsig_create_record(&signer, region);
+	tsig_create_record(&verifier, region);
+	tsig_sign_query(&signer, packet, algo, key, 1);
+	len = buffer_remaining(packet);
+	memcpy(wire, buffer_begin(packet), len);
+
+	get_time(&start);
+	for(i=0; i<count; i++) {
+		buffer_clear(packet);
+		buffer_write(packet, wire, len);
+		buffer_flip(packet);
+		good += tsig_verify_query(&verifier, packet);
+	}
+	get_time(&end);
+	CuAssert(tc, "all queries verified", good == count);
+	timespec_subtract(&end, &start);
+	elapsed = (double)end.tv_sec + (double)end.tv_nsec/1.0e9;
+	printf("tsig verify: %d queries, %g sec, %g queries/sec\n",
+		count, elapsed, (elapsed>0?(double)count/elapsed:0.0));
+
+	tsig_key_clear_state(key);
+	tsig_del_key(key);
+	region_destroy(region);
+#else
+	(void)tc;
+#endif /* HAVE_SSL */
+}
@@ -24,6 +24,7 @@ static void init_context(void *context,
 			 tsig_key_type *key);
 static void update(void *context, const void *data, size_t size);
 static void final(void *context, uint8_t *digest, size_t *size);
+static void delete_state(void *state);
 
 #ifdef HAVE_EVP_MAC_CTX_NEW
 struct tsig_openssl_data {
@@ -133,6 +134,7 @@ tsig_openssl_init_algorithm(region_type* region,
 	algorithm->hmac_init_context = init_context;
 	algorithm->hmac_update = update;
 	algorithm->hmac_final = final;
+	algorithm->hmac_delete_state = delete_state;
 	tsig_add_algorithm(algorithm);
 
 #ifdef HAVE_EVP_MAC_CTX_NEW
@@ -209,27 +211,32 @@ create_context(region_type *region)
 	return context;
 }
 
-static void
-init_context(void *context,
-			  tsig_algorithm_type *algorithm,
-			  tsig_key_type *key)
+#if defined(HAVE_EVP_MAC_CTX_NEW) || defined(HAVE_HMAC_CTX_NEW)
+/* create the HMAC state after hashing the key, or NULL on failure */
+static void *
+create_state(tsig_algorithm_type *algorithm, tsig_key_type *key)
 {
 #ifndef HAVE_EVP_MAC_CTX_NEW
-	HMAC_CTX *ctx = (HMAC_CTX *) context;
-	const EVP_MD *md = (const EVP_MD *) algorithm->data;
-	HMAC_Init_ex(ctx, key->data, key->size, md, NULL);
+	HMAC_CTX *state = HMAC_CTX_new();
+	if(!state) {
+		log_msg(LOG_ERR, "could not HMAC_CTX_new");
+		return NULL;
+	}
+	if(!HMAC_Init_ex(state, key->data, key->size,
+		(const EVP_MD *) algorithm->data, NULL)) {
+		log_msg(LOG_ERR, "could not HMAC_Init_ex");
+		HMAC_CTX_free(state);
+		return NULL;
+	}
+	return state;
 #else
 	OSSL_PARAM params[3];
 	struct tsig_openssl_data* algo_data = (struct tsig_openssl_data*)
 		algorithm->data;
-	struct tsig_openssl_context* c = (struct tsig_openssl_context*)context;
-	if(c->hmac_ctx) {
-		EVP_MAC_CTX_free(c->hmac_ctx);
-	}
-	c->hmac_ctx = EVP_MAC_CTX_new(algo_data->mac);
-	if(!c->hmac_ctx) {
+	EVP_MAC_CTX* state = EVP_MAC_CTX_new(algo_data->mac);
+	if(!state) {
 		log_msg(LOG_ERR, "could not EVP_MAC_CTX_new");
-		return;
+		return NULL;
 	}
 	params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
 		(char*)algo_data->digest, 0);
@@ -237,20 +244,66 @@ init_context(void *context,
 		key->data, key->size);
 	params[2] = OSSL_PARAM_construct_end();
 #ifdef HAVE_EVP_MAC_CTX_SET_PARAMS
-	if(EVP_MAC_CTX_set_params(c->hmac_ctx, params) <= 0) {
+	if(EVP_MAC_CTX_set_params(state, params) <= 0) {
 		log_msg(LOG_ERR, "could not EVP_MAC_CTX_set_params");
-		EVP_MAC_CTX_free(c->hmac_ctx);
-		c->hmac_ctx = NULL;
-		return;
+		EVP_MAC_CTX_free(state);
+		return NULL;
 	}
 #else
-	if(EVP_MAC_set_ctx_params(hmac_ctx, params) <= 0) {
+	if(EVP_MAC_set_ctx_params(state, params) <= 0) {
 		log_msg(LOG_ERR, "could not EVP_MAC_set_ctx_params");
+		EVP_MAC_CTX_free(state);
+		return NULL;
+	}
+#endif
+	return state;
+#endif
+}
+
+/* get the HMAC state for the key, create it if needed */
+static void *
+get_state(tsig_algorithm_type *algorithm, tsig_key_type *key)
+{
+	if(key->state && key->state_algorithm == algorithm)
+		return key->state;
+	tsig_key_clear_state(key);
+	key->state = create_state(algorithm, key);
+	if(key->state)
+		key->state_algorithm = algorithm;
+	return key->state;
+}
+#endif /* HAVE_EVP_MAC_CTX_NEW || HAVE_HMAC_CTX_NEW */
+
+static void
+init_context(void *context,
+			  tsig_algorithm_type *algorithm,
+			  tsig_key_type *key)
+{
+#ifndef HAVE_EVP_MAC_CTX_NEW
+	HMAC_CTX *ctx = (HMAC_CTX *) context;
+#ifdef HAVE_HMAC_CTX_NEW
+	/* copy the state after the key, so only the message is hashed */
+	HMAC_CTX *state = (HMAC_CTX *) get_state(algorithm, key);
+	if(state && HMAC_CTX_copy(ctx, state))
+		return;
+#endif
+	HMAC_Init_ex(ctx, key->data, key->size,
+		(const EVP_MD *) algorithm->data, NULL);
+#else
+	struct tsig_openssl_context* c = (struct tsig_openssl_context*)context;
+	EVP_MAC_CTX* state = (EVP_MAC_CTX*)get_state(algorithm, key);
+	if(c->hmac_ctx) {
 		EVP_MAC_CTX_free(c->hmac_ctx);
 		c->hmac_ctx = NULL;
+	}
+	if(!state)
+		return;
+	/* copy the state after the key, so only the message is hashed */
+	c->hmac_ctx = EVP_MAC_CTX_dup(state);
+	if(!c->hmac_ctx) {
+		log_msg(LOG_ERR, "could not EVP_MAC_CTX_dup");
 		return;
 	}
-#endif
 	c->outsize = algorithm->maximum_digest_size;
 #endif
 }
@@ -285,6 +338,20 @@ final(void *context, uint8_t *digest, size_t *size)
 #endif
 }
 
+static void
+delete_state(void *state)
+{
+#ifndef HAVE_EVP_MAC_CTX_NEW
+#ifdef HAVE_HMAC_CTX_NEW
+	HMAC_CTX_free((HMAC_CTX *) state);
+#else
+	(void)state;
+#endif
+#else
+	EVP_MAC_CTX_free((EVP_MAC_CTX *) state);
+#endif
+}
+
 void
 tsig_openssl_finalize()
 {
@@ -179,6 +179,16 @@ tsig_del_key(tsig_key_type *key)
 	region_recycle(tsig_region, entry, sizeof(tsig_key_table_type));
 }
 
+void
+tsig_key_clear_state(tsig_key_type *key)
+{
+	if(!key || !key->state)
+		return;
+	key->state_algorithm->hmac_delete_state(key->state);
+	key->state = NULL;
+	key->state_algorithm = NULL;
+}
+
 tsig_key_type*
 tsig_find_key(const dname_type* name)
 {
@@ -90,6 +90,12 @@ struct tsig_algorithm
 	 * least maximum_digest_size bytes.
 	 */
 	void  (*hmac_final)(void *context, uint8_t *digest, size_t *size);
+
+	/*
+	 * Delete the keyed HMAC state that hmac_init_context stored in
+	 * the key.
+	 */
+	void  (*hmac_delete_state)(void *state);
 };
 
 /*
@@ -100,6 +106,13 @@ struct tsig_key
 	const dname_type *name;
 	size_t            size;
 	uint8_t		 *data;
+
+	/*
+	 * The HMAC state after hashing the key, made by the algorithm on
+	 * first use and copied for every message, or NULL.
+	 */
+	void                *state;
+	tsig_algorithm_type *state_algorithm;
 };
 
 struct tsig_record
@@ -142,6 +155,12 @@ int tsig_init(region_type *region);
 void tsig_add_key(tsig_key_type *key);
 void tsig_del_key(tsig_key_type *key);
 
+/*
+ * Delete the keyed HMAC state of the key, when the key data changes
+ * or the key is removed.
+ */
+void tsig_key_clear_state(tsig_key_type *key);
+
 /*
  * Add the specified algorithm to the TSIG algorithm table.
  */
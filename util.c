@@ -38,7 +38,7 @@
 #include "zonec.h"
 #include "nsd.h"
 
-#ifdef USE_MMAP_ALLOC
+#if defined(USE_MMAP_ALLOC) || defined(HAVE_MMAP)
 #include <sys/mman.h>
 
 #if defined(MAP_ANON) && !defined(MAP_ANONYMOUS)
@@ -47,7 +47,7 @@
 #define	MAP_ANON	MAP_ANONYMOUS
 #endif
 
-#endif /* USE_MMAP_ALLOC */
+#endif /* USE_MMAP_ALLOC || HAVE_MMAP */
 
 #ifndef NDEBUG
 unsigned nsd_debug_facilities = 0xffff;
@@ -393,6 +393,72 @@ mmap_free(void *ptr)
 
 #endif /* USE_MMAP_ALLOC */
 
+#ifdef HAVE_MMAP
+void *
+hugepage_alloc(size_t size)
+{
+	char *base;
+	size_t len = size + HUGEPAGE_ALLOC_HEADER_SIZE;
+
+#ifdef MAP_ANONYMOUS
+	if (len % HUGEPAGE_SIZE != 0)
+#endif
+	{
+		/* not a region chunk, but a large object, malloc it */
+		base = (char *) xalloc(len);
+		*((size_t*) base) = 0;
+		return base + HUGEPAGE_ALLOC_HEADER_SIZE;
+	}
+#ifdef MAP_ANONYMOUS
+	{
+		/* map it aligned on the huge page size, so that the kernel
+		 * can use transparent huge pages for it.  Not MAP_HUGETLB:
+		 * the reload changes the database copy-on-write, and that
+		 * copy gets SIGBUS when the huge page pool is exhausted */
+		size_t head;
+		char *p = mmap(NULL, len + HUGEPAGE_SIZE, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (p == MAP_FAILED) {
+			log_msg(LOG_ERR, "mmap failed: %s", strerror(errno));
+			exit(1);
+		}
+		head = (HUGEPAGE_SIZE - ((uintptr_t)p % HUGEPAGE_SIZE))
+			% HUGEPAGE_SIZE;
+		if (head != 0)
+			(void)munmap(p, head);
+		(void)munmap(p + head + len, HUGEPAGE_SIZE - head);
+		base = p + head;
+#ifdef MADV_HUGEPAGE
+		(void)madvise(base, len, MADV_HUGEPAGE);
+#endif
+	}
+
+	*((size_t*) base) = len;
+	return base + HUGEPAGE_ALLOC_HEADER_SIZE;
+#endif /* MAP_ANONYMOUS */
+}
+
+void
+hugepage_free(void *ptr)
+{
+	char *base;
+	size_t size;
+
+	if (!ptr) return;
+
+	base = (char *) ptr - HUGEPAGE_ALLOC_HEADER_SIZE;
+	size = *((size_t*) base);
+	if (size == 0) {
+		free(base);
+		return;
+	}
+	if (munmap(base, size) == -1) {
+		log_msg(LOG_ERR, "munmap failed: %s", strerror(errno));
+		exit(1);
+	}
+}
+#endif /* HAVE_MMAP */
+
 int
 write_data(FILE *file, const void *data, size_t size)
 {
@@ -875,17 +941,15 @@ set_previous_owner(struct state_pretty_rr *state, const dname_type *dname)
 }
 
 int
-print_rr(FILE *out,
-         struct state_pretty_rr *state,
-         rr_type *record,
-	 region_type* rr_region,
-	 buffer_type* output)
+print_rr_buffer(buffer_type* output,
+	struct state_pretty_rr *state,
+	rr_type *record,
+	region_type* rr_region)
 {
         rrtype_descriptor_type *descriptor
                 = rrtype_descriptor_by_type(record->type);
         int result;
         const dname_type *owner = domain_dname(record->owner);
-	buffer_clear(output);
         if (state) {
 		if (!state->previous_owner
 			|| dname_compare(state->previous_owner, owner) != 0) {
@@ -926,6 +990,21 @@ print_rr(FILE *out,
 
 	if (result) {
 		buffer_printf(output, "\n");
+	}
+	return result;
+}
+
+int
+print_rr(FILE *out,
+         struct state_pretty_rr *state,
+         rr_type *record,
+	 region_type* rr_region,
+	 buffer_type* output)
+{
+	int result;
+	buffer_clear(output);
+	result = print_rr_buffer(output, state, record, rr_region);
+	if (result) {
 		buffer_flip(output);
 		result = write_data(out, buffer_current(output),
 		buffer_remaining(output));
@@ -169,6 +169,15 @@ void *mmap_alloc(size_t size);
 void mmap_free(void *ptr);
 #endif /* USE_MMAP_ALLOC */
 
+/*
+ * Huge page allocator routines, for region chunks of HUGEPAGE_CHUNK_SIZE.
+ * Other sizes are malloced.
+ */
+#ifdef HAVE_MMAP
+void *hugepage_alloc(size_t size);
+void hugepage_free(void *ptr);
+#endif /* HAVE_MMAP */
+
 /*
  * Write SIZE bytes of DATA to FILE.  Report an error on failure.
  *
@@ -387,6 +396,10 @@ struct state_pretty_rr* create_pretty_rr(struct region* region);
 /* print rr to file, returns 0 on failure(nothing is written) */
 int print_rr(FILE *out, struct state_pretty_rr* state, struct rr *record,
 	struct region* tmp_region, struct buffer* tmp_buffer);
+/* print rr text at the position in the buffer, the buffer grows if
+ * needed, returns 0 on failure (partial text may be in the buffer) */
+int print_rr_buffer(struct buffer* output, struct state_pretty_rr* state,
+	struct rr *record, struct region* tmp_region);
 
 /*
  * Convert a numeric rcode value to a human readable string
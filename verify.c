@@ -190,6 +190,15 @@ static void close_stream(struct verifier *verifier, struct verifier_stream *stre
 	stream->fd = -1;
 }
 
+static void close_feed(struct verifier *verifier)
+{
+	event_del(&verifier->zone_feed.event);
+	close(verifier->zone_feed.fd);
+	verifier->zone_feed.fd = -1;
+	region_destroy(verifier->zone_feed.rr_region);
+	region_destroy(verifier->zone_feed.region);
+}
+
 static void close_verifier(struct verifier *verifier)
 {
 	/* unregister events and close streams (in that order) */
@@ -199,11 +208,8 @@ static void close_verifier(struct verifier *verifier)
 		verifier->timeout.tv_usec = 0;
 	}
 
-	if(verifier->zone_feed.fh != NULL) {
-		event_del(&verifier->zone_feed.event);
-		fclose(verifier->zone_feed.fh);
-		verifier->zone_feed.fh = NULL;
-		region_destroy(verifier->zone_feed.region);
+	if(verifier->zone_feed.fd != -1) {
+		close_feed(verifier);
 	}
 
 	close_stream(verifier, &verifier->error_stream);
@@ -215,30 +221,58 @@ static void close_verifier(struct verifier *verifier)
 }
 
 /*
- * Feed zone to verifier over STDIN as it becomes available.
+ * Feed zone to verifier over STDIN as it becomes available. The RRs are
+ * printed in a chunk of text, that is written with as few writes as the
+ * pipe allows.
  */
 static void verify_handle_feed(int fd, short event, void *arg)
 {
 	struct verifier *verifier;
+	struct buffer *buffer;
 	struct rr *rr;
+	ssize_t ret;
 
-	(void)fd;
 	assert(event == EV_WRITE);
 	assert(arg != NULL);
 
 	verifier = (struct verifier *)arg;
-	if((rr = zone_rr_iter_next(&verifier->zone_feed.rriter)) != NULL) {
-		print_rr(verifier->zone_feed.fh,
-		         verifier->zone_feed.rrprinter,
-		         rr,
-		         verifier->zone_feed.region,
-		         verifier->zone_feed.buffer);
-	} else {
-		event_del(&verifier->zone_feed.event);
-		fclose(verifier->zone_feed.fh);
-		verifier->zone_feed.fh = NULL;
-		region_destroy(verifier->zone_feed.region);
+	buffer = verifier->zone_feed.buffer;
+	if(buffer_remaining(buffer) == 0) {
+		buffer_clear(buffer);
+		while(buffer_position(buffer) < VERIFY_FEED_CHUNK &&
+		      (rr = zone_rr_iter_next(&verifier->zone_feed.rriter))
+		      != NULL)
+		{
+			size_t mark = buffer_position(buffer);
+			if(!print_rr_buffer(buffer,
+			                    verifier->zone_feed.rrprinter,
+			                    rr,
+			                    verifier->zone_feed.rr_region))
+			{
+				buffer_set_position(buffer, mark);
+			}
+		}
+		buffer_flip(buffer);
+		if(buffer_remaining(buffer) == 0) {
+			/* end of the zone */
+			close_feed(verifier);
+			return;
+		}
+	}
+
+	ret = write(fd, buffer_current(buffer), buffer_remaining(buffer));
+	if(ret == -1) {
+		if(errno == EAGAIN || errno == EINTR)
+			return;
+		/* the verifier does not have to read all of the zone */
+		if(errno != EPIPE)
+			log_msg(LOG_ERR, "verify: could not feed zone %s to "
+			                 "verifier: %s", verifier->zone->opts->name,
+			                 strerror(errno));
+		close_feed(verifier);
+		return;
 	}
+	buffer_skip(buffer, ret);
 }
 
 /*
@@ -319,6 +353,8 @@ void verify_handle_exit(int fd, short event, void *arg)
 		}
 
 		if(verifier == NULL) {
+			/* a background zonefile writer can exit too */
+			(void)namedb_zonefile_writer_exited(nsd, pid, wstatus);
 			continue;
 		}
 
@@ -415,14 +451,12 @@ void verify_zone(struct nsd *nsd, struct zone *zone)
 	struct verifier *verifier = NULL;
 	int32_t timeout;
 	char **command;
-	FILE *fin;
 	int fdin, fderr, fdout, flags;
 
 	assert(nsd != NULL);
 	assert(nsd->verifier_count < nsd->verifier_limit);
 	assert(zone != NULL);
 
-	fin = NULL;
 	fdin = fdout = fderr = -1;
 
 	/* search for available verifier slot */
@@ -487,14 +521,13 @@ void verify_zone(struct nsd *nsd, struct zone *zone)
 		goto fail_fcntl;
 	}
 	if (fdin >= 0) {
-		if ((fin = fdopen(fdin, "w")) == NULL) {
-			log_msg(LOG_ERR, "verify: fdopen(stdin, ...) for "
-			                 "zone %s: %s",
-		                         zone->opts->name, strerror(errno));
+		flags = fcntl(fdin, F_GETFL, 0);
+		if (fcntl(fdin, F_SETFL, flags | O_NONBLOCK) == -1) {
+			log_msg(LOG_ERR, "verify: fcntl(stdin, ..., O_NONBLOCK) "
+			                 "for zone %s: %s",
+			                 zone->opts->name, strerror(errno));
 			goto fail_fcntl;
 		}
-		/* write unbuffered */
-		setbuf(fin, NULL);
 	}
 
 	verifier->zone = zone;
@@ -535,20 +568,24 @@ void verify_zone(struct nsd *nsd, struct zone *zone)
 		goto fail_stdout;
 	}
 
-	if(fin != NULL) {
-		verifier->zone_feed.fh = fin;
+	if(fdin >= 0) {
+		verifier->zone_feed.fd = fdin;
 
 		zone_rr_iter_init(&verifier->zone_feed.rriter, zone);
 
-		verifier->zone_feed.rrprinter
-			= create_pretty_rr(nsd->server_region);
 		verifier->zone_feed.region
 			= region_create(xalloc, free);
+		verifier->zone_feed.rr_region
+			= region_create(xalloc, free);
+		verifier->zone_feed.rrprinter
+			= create_pretty_rr(verifier->zone_feed.region);
 		verifier->zone_feed.buffer
-			= buffer_create(nsd->server_region, MAX_RDLENGTH);
+			= buffer_create(verifier->zone_feed.region,
+			                VERIFY_FEED_CHUNK + MAX_RDLENGTH);
+		buffer_flip(verifier->zone_feed.buffer);
 
 		event_set(&verifier->zone_feed.event,
-		          fileno(verifier->zone_feed.fh),
+		          verifier->zone_feed.fd,
 			  EV_WRITE|EV_PERSIST,
 			  &verify_handle_feed,
 			  verifier);
@@ -590,11 +627,15 @@ void verify_zone(struct nsd *nsd, struct zone *zone)
 fail_timeout:
 	verifier->timeout.tv_sec = 0;
 	verifier->timeout.tv_usec = 0;
-	if(fin != NULL) {
+	if(fdin >= 0) {
 		event_del(&verifier->zone_feed.event);
 	}
 fail_stdin:
-	verifier->zone_feed.fh = NULL;
+	if(fdin >= 0) {
+		region_destroy(verifier->zone_feed.rr_region);
+		region_destroy(verifier->zone_feed.region);
+	}
+	verifier->zone_feed.fd = -1;
 	event_del(&verifier->output_stream.event);
 fail_stdout:
 	verifier->output_stream.fd = -1;
@@ -603,9 +644,7 @@ fail_stderr:
 	verifier->error_stream.fd = -1;
 fail_fcntl:
 	kill_verifier(verifier);
-	if(fin != NULL) {
-		fclose(fin);
-	} else if (fdin >= 0) {
+	if (fdin >= 0) {
 		close(fdin);
 	}
 	close(fdout);
@@ -22,17 +22,24 @@
 
 /*
  * Track position in zone to feed verifier more data as the input descriptor
- * becomes available.
+ * becomes available. The zone text is printed in chunks of about
+ * VERIFY_FEED_CHUNK in the buffer, and written to the nonblocking fd.
  */
 struct verifier_zone_feed {
-	FILE *fh;
+	int fd;
 	struct event event;
 	zone_rr_iter_type rriter;
 	struct state_pretty_rr *rrprinter;
+	/* region for the printer and buffer, destroyed when done */
 	struct region *region;
+	/* temporary region for printing RRs */
+	struct region *rr_region;
 	struct buffer *buffer;
 };
 
+/* size of the text chunks written to the verifier, the pipe buffer size */
+#define VERIFY_FEED_CHUNK 65536
+
 /* 40 is (estimated) space already used on each logline.
  * (time, pid, priority, etc)
  */
@@ -225,6 +225,7 @@ xfrd_deinit_catalog_consumer_zone(xfrd_state_type* xfrd,
 {
 	struct xfrd_catalog_consumer_zone* consumer_zone;
 	zone_type* zone;
+	int deleted = 0;
 
 	if (!(consumer_zone =(struct xfrd_catalog_consumer_zone*)rbtree_delete(
 			xfrd->catalog_consumer_zones, dname))) {
@@ -247,7 +248,10 @@ xfrd_deinit_catalog_consumer_zone(xfrd_state_type* xfrd,
 			"de-initializing catalog consumer zone '%s'",
 			cmz->options.name, consumer_zone->options->name);
 		catalog_del_consumer_member_zone(consumer_zone, cmz);
+		deleted = 1;
 	}
+	if (deleted)
+		xfrd_set_reload_now(xfrd);
 	if ((zone = namedb_find_zone(xfrd->nsd->db, dname))) {
 		namedb_zone_delete(xfrd->nsd->db, zone);
 	}
@@ -351,7 +355,6 @@ catalog_del_consumer_member_zone(
 	/* create deletion task */
 	task_new_del_zone(xfrd->nsd->task[xfrd->nsd->mytask],
 			xfrd->last_task, dname);
-	xfrd_set_reload_now(xfrd);
 	/* delete it in xfrd */
 	if(zone_is_slave(&consumer_member_zone->options)) {
 		xfrd_del_slave_zone(xfrd, dname);
@@ -483,106 +486,83 @@ static void debug_log_consumer_members(
 # define debug_log_consumer_members(x) /* nothing */
 #endif
 
+/* A change to the member zones of a catalog consumer zone */
+struct catalog_member_change {
+	struct catalog_member_change* next;
+	/* the current member zone to delete or to change the pattern of */
+	struct catalog_member_zone* cmz;
+	/* the member_id and member zone domain to add */
+	domain_type* member_id;
+	domain_type* member_domain;
+	/* the pattern for the changed or added member zone */
+	struct pattern_options* pattern;
+};
+
+/* The changes to the member zones, collected in a walk over the catalog
+ * and applied together after the walk. */
+struct catalog_member_delta {
+	struct catalog_member_change *del, **del_last;
+	struct catalog_member_change *change, **change_last;
+	struct catalog_member_change *add, **add_last;
+};
+
 static void
-xfrd_process_catalog_consumer_zone(
-		struct xfrd_catalog_consumer_zone* consumer_zone)
+catalog_member_delta_init(struct catalog_member_delta* delta)
 {
-	zone_type* zone;
-	const dname_type* dname;
+	delta->del = NULL;
+	delta->del_last = &delta->del;
+	delta->change = NULL;
+	delta->change_last = &delta->change;
+	delta->add = NULL;
+	delta->add_last = &delta->add;
+}
+
+/* append a change at the end of the list, to keep the member_id order */
+static void
+catalog_member_delta_append(region_type* region,
+	struct catalog_member_change*** last, struct catalog_member_zone* cmz,
+	domain_type* member_id, domain_type* member_domain,
+	struct pattern_options* pattern)
+{
+	struct catalog_member_change* c = (struct catalog_member_change*)
+		region_alloc(region, sizeof(*c));
+	c->next = NULL;
+	c->cmz = cmz;
+	c->member_id = member_id;
+	c->member_domain = member_domain;
+	c->pattern = pattern;
+	**last = c;
+	*last = &c->next;
+}
+
+/* Compare the member zones in the catalog with the current member zones,
+ * in one pass over both, and collect the changes in delta.
+ * Returns 0 if the catalog is invalid, nothing is changed then. */
+static int
+catalog_consumer_member_delta(struct xfrd_catalog_consumer_zone* consumer_zone,
+	zone_type* zone, region_type* region, struct catalog_member_delta* delta)
+{
+	const dname_type* dname = (const dname_type*)consumer_zone->node.key;
 	domain_type *match, *closest_encloser, *member_id, *group;
 	rrset_type *rrset;
 	size_t i;
-	uint8_t version_2_found;
 	/* Currect catalog member zone */
-	rbnode_type* cursor;
+	rbnode_type* cursor = rbtree_first(&consumer_zone->member_ids);
 	struct pattern_options *default_pattern = NULL;
-	/* A transfer of a catalog zone can contain deletion and adding of
-	 * the same member zone. In such cases it can occur that the member
-	 * is tried to be added before it is deleted. For these exceptional
-	 * cases, we will rewalk the zone after the first pass, to retry
-	 * adding those zones.
-	 *
-	 * Initial pass is mode "try_to_add".
-	 * If a zone cannot be added, mode is set to "retry_to_add"
-	 * If after the first pass the mode is "retry_to_add",
-	 *    mode will be set to "just_add", and a second pass is done.
-	 */
-	enum { try_to_add, retry_to_add, just_add } mode;
 
-	assert(consumer_zone);
-	if (!xfrd->nsd->db) {
-		xfrd->nsd->db = namedb_open(xfrd->nsd->options);
-	}
-	dname = (const dname_type*)consumer_zone->node.key;
-	if (dname->name_size > 247) {
-		make_catalog_consumer_invalid(consumer_zone, "name too long");
-		return;
-	}
-	if (dname->label_count > 126) {
-		make_catalog_consumer_invalid(consumer_zone,"too many labels");
-		return;
-	}
-	zone = namedb_find_zone(xfrd->nsd->db, dname);
-	if (!zone) {
-		zone = namedb_zone_create(xfrd->nsd->db, dname,
-				consumer_zone->options);
-		namedb_read_zonefile(xfrd->nsd, zone, NULL, NULL);
-	}
-	if (timespec_compare(&consumer_zone->mtime, &zone->mtime) == 0) {
-		/* Not processing unchanged catalog consumer zone */
-		return;
-	}
-	consumer_zone->mtime = zone->mtime;
-	/* start processing */
-	/* Lookup version.<consumer_zone> TXT and check that it is version 2 */
-	if(!namedb_lookup(xfrd->nsd->db, label_plus_dname("version", dname),
-				&match, &closest_encloser)
-	|| !(rrset = domain_find_rrset(match, zone, TYPE_TXT))) {
-		make_catalog_consumer_invalid(consumer_zone,
-			"'version.%s TXT RRset not found",
-			consumer_zone->options->name);
-		return;
-	}
-	version_2_found = 0;
-	for (i = 0; i < rrset->rr_count; i++) {
-		if (rrset->rrs[i].rdata_count != 1)
-			continue;
-		if (rrset->rrs[i].rdatas[0].data[0] == 2
-		&&  ((uint8_t*)(rrset->rrs[i].rdatas[0].data + 1))[0] == 1
-		&&  ((uint8_t*)(rrset->rrs[i].rdatas[0].data + 1))[1] == '2') {
-			version_2_found = 1;
-			break;
-		}
-	}
-	if (!version_2_found) {
-		make_catalog_consumer_invalid(consumer_zone,
-			"'version.%s' TXT RR with value \"2\" not found",
-			consumer_zone->options->name);
-		return;
-	}
-	/* Walk over all names under zones.<consumer_zone> */
+	/* Walk over all names under zones.<consumer_zone>. If it does not
+	 * exist, the catalog has no members. This is just fine. But there
+	 * may be members that need to be deleted.
+	 */
 	if(!namedb_lookup(xfrd->nsd->db, label_plus_dname("zones", dname),
-				&match, &closest_encloser)) {
-		/* zones.<consumer_zone> does not exist, so the catalog has no
-		 * members. This is just fine. But there may be members that need
-		 * to be deleted.
-		 */
-		cursor = rbtree_first(&consumer_zone->member_ids);
-		mode = just_add;
-		goto delete_members;
-	}
-	mode = consumer_zone->member_ids.count ? try_to_add : just_add;
-retry_adding:
-	cursor = rbtree_first(&consumer_zone->member_ids);
-	for ( member_id = domain_next(match)
+				&match, &closest_encloser))
+		match = NULL;
+	for ( member_id = match ? domain_next(match) : NULL
 	    ; member_id && domain_is_subdomain(member_id, match)
 	    ; member_id = domain_next(member_id)) {
 		domain_type *member_domain;
-		char member_domain_str[5 * MAXDOMAINLEN];
-		struct zone_options* zopt;
-		int valid_group_values;
+		int valid_group_values, cmp = 0;
 		struct pattern_options *pattern = NULL;
-		struct catalog_member_zone* to_add;
 
 		if (domain_dname(member_id)->label_count > dname->label_count+2
 		||  !(rrset = domain_find_rrset(member_id, zone, TYPE_PTR)))
@@ -596,18 +576,15 @@ retry_adding:
 		 *    NOT be processed (see Section 5.1).
 		 */
 		if (rrset->rr_count != 1) {
-			make_catalog_consumer_invalid(consumer_zone, 
+			make_catalog_consumer_invalid(consumer_zone,
 				"only a single PTR RR expected on '%s'",
 				domain_to_string(member_id));
-			return;
+			return 0;
 		}
 		/* A PTR rr always has 1 rdata element which is a dname */
 		if (rrset->rrs[0].rdata_count != 1)
 			continue;
 		member_domain = rrset->rrs[0].rdatas[0].domain;
-		domain_to_string_buf(member_domain, member_domain_str);
-		/* remove trailing dot */
-		member_domain_str[strlen(member_domain_str) - 1] = 0;
 
 		valid_group_values = 0;
 		/* Lookup group.<member_id> TXT for matching patterns  */
@@ -671,224 +648,263 @@ retry_adding:
 
 		else if (!(pattern = default_pattern =
 				catalog_member_pattern(consumer_zone))) {
-			make_catalog_consumer_invalid(consumer_zone, 
+			make_catalog_consumer_invalid(consumer_zone,
 				"missing 'group.%s' TXT RR and no default "
 				"pattern from \"catalog-member-pattern\"",
 				domain_to_string(member_id));
-			return;
+			return 0;
 		}
-		if (cursor == RBTREE_NULL)
-			; /* End of the current member zones list.
-			   * From here onwards, zones will only be added.
-			   */
-		else {
-			int cmp = 0;
-#ifndef NDEBUG
-			char member_id_str[5 * MAXDOMAINLEN];
-			domain_to_string_buf(member_id, member_id_str);
-#endif
-			DEBUG(DEBUG_XFRD,1, (LOG_INFO, "Comparing %s with %s",
-				member_id_str,
-				dname_to_string(cursor_member_id(cursor),
-					NULL)));
-
-			while (cursor != RBTREE_NULL && 
-			       (cmp = dname_compare(
-					domain_dname(member_id),
-					cursor_member_id(cursor))) > 0) {
-				/* member_id is ahead of the current catalog
-				 * member zone pointed to by cursor.
-				 * The member zone must be deleted.
-				 */
-				struct catalog_member_zone* to_delete =
-					cursor_cmz(cursor);
-#ifndef NDEBUG
-				const char *member_id_to_delete_str =
-				   dname_to_string(to_delete->member_id, NULL);
-#endif
-				cursor = rbtree_next(cursor);
-
-				DEBUG(DEBUG_XFRD,1, (LOG_INFO,
-					"%s > %s: delete %s",
-					member_id_str,
-					member_id_to_delete_str,
-					member_id_to_delete_str));
-				catalog_del_consumer_member_zone(
-						consumer_zone, to_delete);
-				if(cursor != RBTREE_NULL)
-					DEBUG(DEBUG_XFRD,1, (LOG_INFO,
-						"Comparing %s with %s",
-						member_id_str,
-						dname_to_string(
-							cursor_member_id(cursor),
-							NULL)));
-			}
-			if (cursor != RBTREE_NULL && cmp == 0) {
-				/* member_id is also in an current catalog
-				 * member zone, and cursor is pointing
-				 * to it. So, move along ...
-				 */
-				/* ... but first check if the pattern needs
-				 * a change
-				 */
-				DEBUG(DEBUG_XFRD,1, (LOG_INFO, "%s == %s: "
-				    "Compare pattern %s with %s",
-				    member_id_str, member_id_str,
-				    cursor_cmz(cursor)->options.pattern->pname,
-				    pattern->pname));
-
-				if (cursor_cmz(cursor)->options.pattern ==
-						pattern)
-					; /* pass: Pattern remains the same */
-				else {
-					/* Changing patterns is basically
-					 * deleting and adding the zone again
-					 */
-					zopt  = &cursor_cmz(cursor)->options;
-					dname = (dname_type *)zopt->node.key;
-					task_new_del_zone(
-					    xfrd->nsd->task[xfrd->nsd->mytask],
-					    xfrd->last_task,
-					    dname);
-					xfrd_set_reload_now(xfrd);
-					if(zone_is_slave(zopt)) {
-						xfrd_del_slave_zone( xfrd
-						                   , dname);
-					}
-					xfrd_del_notify(xfrd, dname);
+		while (cursor != RBTREE_NULL &&
+		       (cmp = dname_compare(domain_dname(member_id),
+				cursor_member_id(cursor))) > 0) {
+			/* member_id is ahead of the current catalog member
+			 * zone pointed to by cursor.
+			 * The member zone must be deleted.
+			 */
+			catalog_member_delta_append(region, &delta->del_last,
+				cursor_cmz(cursor), NULL, NULL, NULL);
+			cursor = rbtree_next(cursor);
+		}
+		if (cursor != RBTREE_NULL && cmp == 0) {
+			/* member_id is also in an current catalog member zone,
+			 * check if the pattern needs a change
+			 */
+			if (cursor_cmz(cursor)->options.pattern != pattern)
+				catalog_member_delta_append(region,
+					&delta->change_last, cursor_cmz(cursor),
+					NULL, NULL, pattern);
+			cursor = rbtree_next(cursor);
+			continue;
+		}
+		/* member_id is not in the current catalog member zone
+		 * list, so it must be added
+		 */
+		catalog_member_delta_append(region, &delta->add_last, NULL,
+			member_id, member_domain, pattern);
+	}
+	while (cursor != RBTREE_NULL) {
+		/* Any current catalog member zones remaining, don't have an
+		 * member_id in the catalog anymore, so should be deleted too.
+		 */
+		catalog_member_delta_append(region, &delta->del_last,
+			cursor_cmz(cursor), NULL, NULL, NULL);
+		cursor = rbtree_next(cursor);
+	}
+	return 1;
+}
+
+/* Start xfrd processing for a new or changed member zone. The first
+ * refresh of the secondary zones over xfrd-catalog-refresh-rate is
+ * scheduled in later seconds. */
+static void
+catalog_consumer_member_start(struct zone_options* zopt, size_t* num_refresh)
+{
+	int rate = xfrd->nsd->options->xfrd_catalog_refresh_rate;
+	xfrd_zone_type* xzone;
 #ifdef MULTIPLE_CATALOG_CONSUMER_ZONES
-					if(zone_is_catalog_consumer(zopt)) {
-						xfrd_deinit_catalog_consumer_zone(
-								xfrd, dname);
-					}
+	/* add to xfrd - catalog consumer zones */
+	if(zone_is_catalog_consumer(zopt)) {
+		xfrd_init_catalog_consumer_zone(xfrd, zopt);
+	}
 #endif
-					/* It is a catalog consumer member,
-					 * so no need to check if it was a
-					 * catalog producer member zone to 
-					 * delete and add
-					 */
-					zopt->pattern = pattern;
-					task_new_add_zone(
-					    xfrd->nsd->task[xfrd->nsd->mytask],
-					    xfrd->last_task, zopt->name,
-					    pattern->pname,
-					    getzonestatid( xfrd->nsd->options
-					                 , zopt));
-					zonestat_inc_ifneeded();
-					xfrd_set_reload_now(xfrd);
+	/* add to xfrd - notify (for master and slaves) */
+	init_notify_send(xfrd->notify_zones, xfrd->region, zopt);
+	/* add to xfrd - slave */
+	if(!zone_is_slave(zopt))
+		return;
+	xfrd_init_slave_zone(xfrd, zopt);
+	if(rate > 0 && *num_refresh >= (size_t)rate && (xzone =
+		(xfrd_zone_type*)rbtree_search(xfrd->zones, zopt->node.key))) {
+		xfrd_deactivate_zone(xzone);
+		xfrd_set_timer(xzone, (time_t)(*num_refresh / (size_t)rate));
+	}
+	(*num_refresh)++;
+}
+
+/* Apply the collected changes to the member zones. The deletions are done
+ * first, so that a zone that moves to another member_id in the same
+ * transfer can be added again. The tasks for reload are made in one batch,
+ * and reload is scheduled once. */
+static void
+catalog_consumer_apply_delta(struct xfrd_catalog_consumer_zone* consumer_zone,
+	struct catalog_member_delta* delta)
+{
+	struct catalog_member_change* c;
+	size_t num_del = 0, num_change = 0, num_add = 0, num_refresh = 0;
+
+	for(c = delta->del; c; c = c->next) {
+		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "delete catalog member zone %s "
+			"(from %s)", c->cmz->options.name,
+			dname_to_string(c->cmz->member_id, NULL)));
+		catalog_del_consumer_member_zone(consumer_zone, c->cmz);
+		num_del++;
+	}
+	for(c = delta->change; c; c = c->next) {
+		/* Changing patterns is basically deleting and adding the
+		 * zone again
+		 */
+		struct zone_options* zopt = &c->cmz->options;
+		const dname_type* dname = (const dname_type*)zopt->node.key;
+		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "change pattern of catalog "
+			"member zone %s from %s to %s", zopt->name,
+			zopt->pattern->pname, c->pattern->pname));
+		task_new_del_zone(xfrd->nsd->task[xfrd->nsd->mytask],
+			xfrd->last_task, dname);
+		if(zone_is_slave(zopt)) {
+			xfrd_del_slave_zone(xfrd, dname);
+		}
+		xfrd_del_notify(xfrd, dname);
 #ifdef MULTIPLE_CATALOG_CONSUMER_ZONES
-					if(zone_is_catalog_consumer(zopt)) {
-						xfrd_init_catalog_consumer_zone(
-								xfrd, zopt);
-					}
-#endif
-					init_notify_send(xfrd->notify_zones,
-							xfrd->region, zopt);
-					if(zone_is_slave(zopt)) {
-						xfrd_init_slave_zone(
-								xfrd, zopt);
-					}
-				}
-				cursor = rbtree_next(cursor);
-				continue;
-			}
-			/* member_id is not in the current catalog member zone
-			 * list, so it must be added
-			 */
-			assert(cursor == RBTREE_NULL || cmp < 0);
+		if(zone_is_catalog_consumer(zopt)) {
+			xfrd_deinit_catalog_consumer_zone(xfrd, dname);
 		}
+#endif
+		/* It is a catalog consumer member, so no need to check if it
+		 * was a catalog producer member zone to delete and add
+		 */
+		zopt->pattern = c->pattern;
+		task_new_add_zone(xfrd->nsd->task[xfrd->nsd->mytask],
+			xfrd->last_task, zopt->name, c->pattern->pname,
+			getzonestatid(xfrd->nsd->options, zopt));
+		catalog_consumer_member_start(zopt, &num_refresh);
+		num_change++;
+	}
+	for(c = delta->add; c; c = c->next) {
+		char member_domain_str[5 * MAXDOMAINLEN];
+		struct catalog_member_zone* to_add;
+
 		/* See if the zone already exists */
-		zopt = zone_options_find(xfrd->nsd->options,
-				domain_dname(member_domain));
-		if (zopt) {
-			/* Produce warning if zopt is from other catalog.
-			 * Give debug message if zopt is not from this catalog.
-			 */
-			switch(mode) {
-			case try_to_add:
-				mode = retry_to_add;
-				break;
-			case just_add:
-				DEBUG(DEBUG_XFRD,1, (LOG_INFO, "Cannot add "
-					"catalog member zone %s (from %s): "
-					"zone already exists",
-					member_domain_str,
-					domain_to_string(member_id)));
-				break;
-			default:
-				break;
-			}
+		if(zone_options_find(xfrd->nsd->options,
+				domain_dname(c->member_domain))) {
+			DEBUG(DEBUG_XFRD,1, (LOG_INFO, "Cannot add catalog "
+				"member zone %s (from %s): zone already exists",
+				domain_to_string(c->member_domain),
+				domain_to_string(c->member_id)));
 			continue;
 		}
-		/* Add member zone if not already there */
-                log_msg(LOG_INFO, "Adding '%s' PTR '%s'",
-				domain_to_string(member_id),
-				member_domain_str);
-		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "Adding %s PTR %s",
-			domain_to_string(member_id), member_domain_str));
+		domain_to_string_buf(c->member_domain, member_domain_str);
+		/* remove trailing dot */
+		member_domain_str[strlen(member_domain_str) - 1] = 0;
+		VERBOSITY(2, (LOG_INFO, "Adding '%s' PTR '%s'",
+			domain_to_string(c->member_id), member_domain_str));
 		to_add= catalog_member_zone_create(xfrd->nsd->options->region);
 		to_add->options.name = region_strdup(
 				xfrd->nsd->options->region, member_domain_str);
-		to_add->options.pattern = pattern;
+		to_add->options.pattern = c->pattern;
 		if (!nsd_options_insert_zone(xfrd->nsd->options,
 					&to_add->options)) {
 	                log_msg(LOG_ERR, "bad domain name  '%s' pattern %s",
-				member_domain_str,
-				( pattern->pname ? pattern->pname: "<NULL>"));
+				member_domain_str, (c->pattern->pname ?
+				c->pattern->pname: "<NULL>"));
 			zone_options_delete(xfrd->nsd->options,
 					&to_add->options);
 			continue;
 		}
 		to_add->member_id = dname_copy( xfrd->nsd->options->region
-		                           , domain_dname(member_id));
+		                           , domain_dname(c->member_id));
 		/* Insert into the members_id list */
 		to_add->node.key = to_add;
 		if(!rbtree_insert( &consumer_zone->member_ids, &to_add->node)){
 	                log_msg(LOG_ERR, "Error adding '%s' PTR '%s' to "
 				"consumer_zone->member_ids",
-				domain_to_string(member_id),
+				domain_to_string(c->member_id),
 				member_domain_str);
 			break;
-		} else
-			cursor = rbtree_next(&to_add->node);
-		/* make addzone task and schedule reload */
+		}
+		/* make addzone task */
 		task_new_add_zone(xfrd->nsd->task[xfrd->nsd->mytask],
 			xfrd->last_task, member_domain_str,
-			pattern->pname,
+			c->pattern->pname,
 			getzonestatid(xfrd->nsd->options, &to_add->options));
+		catalog_consumer_member_start(&to_add->options, &num_refresh);
+		num_add++;
+	}
+	if(num_del == 0 && num_change == 0 && num_add == 0)
+		return;
+	/* one zonestat task for all the added zones */
+	if(num_change != 0 || num_add != 0)
 		zonestat_inc_ifneeded();
-		xfrd_set_reload_now(xfrd);
-#ifdef MULTIPLE_CATALOG_CONSUMER_ZONES
-		/* add to xfrd - catalog consumer zones */
-		if(zone_is_catalog_consumer(&to_add->options)) {
-			xfrd_init_catalog_consumer_zone(xfrd,&to_add->options);
-		}
-#endif
-		/* add to xfrd - notify (for master and slaves) */
-		init_notify_send(xfrd->notify_zones, xfrd->region,
-				&to_add->options);
-		/* add to xfrd - slave */
-		if(zone_is_slave(&to_add->options)) {
-			xfrd_init_slave_zone(xfrd, &to_add->options);
+	xfrd_set_reload_now(xfrd);
+	VERBOSITY(1, (LOG_INFO, "catalog consumer zone %s: %u member zones "
+		"added, %u deleted, %u changed pattern",
+		consumer_zone->options->name, (unsigned)num_add,
+		(unsigned)num_del, (unsigned)num_change));
+}
+
+static void
+xfrd_process_catalog_consumer_zone(
+		struct xfrd_catalog_consumer_zone* consumer_zone)
+{
+	zone_type* zone;
+	const dname_type* dname;
+	domain_type *match, *closest_encloser;
+	rrset_type *rrset;
+	size_t i;
+	uint8_t version_2_found;
+	region_type* region;
+	struct catalog_member_delta delta;
+
+	assert(consumer_zone);
+	if (!xfrd->nsd->db) {
+		xfrd->nsd->db = namedb_open(xfrd->nsd->options);
+	}
+	dname = (const dname_type*)consumer_zone->node.key;
+	if (dname->name_size > 247) {
+		make_catalog_consumer_invalid(consumer_zone, "name too long");
+		return;
+	}
+	if (dname->label_count > 126) {
+		make_catalog_consumer_invalid(consumer_zone,"too many labels");
+		return;
+	}
+	zone = namedb_find_zone(xfrd->nsd->db, dname);
+	if (!zone) {
+		zone = namedb_zone_create(xfrd->nsd->db, dname,
+				consumer_zone->options);
+		namedb_read_zonefile(xfrd->nsd, zone, NULL, NULL);
+	}
+	if (timespec_compare(&consumer_zone->mtime, &zone->mtime) == 0) {
+		/* Not processing unchanged catalog consumer zone */
+		return;
+	}
+	consumer_zone->mtime = zone->mtime;
+	/* start processing */
+	/* Lookup version.<consumer_zone> TXT and check that it is version 2 */
+	if(!namedb_lookup(xfrd->nsd->db, label_plus_dname("version", dname),
+				&match, &closest_encloser)
+	|| !(rrset = domain_find_rrset(match, zone, TYPE_TXT))) {
+		make_catalog_consumer_invalid(consumer_zone,
+			"'version.%s TXT RRset not found",
+			consumer_zone->options->name);
+		return;
+	}
+	version_2_found = 0;
+	for (i = 0; i < rrset->rr_count; i++) {
+		if (rrset->rrs[i].rdata_count != 1)
+			continue;
+		if (rrset->rrs[i].rdatas[0].data[0] == 2
+		&&  ((uint8_t*)(rrset->rrs[i].rdatas[0].data + 1))[0] == 1
+		&&  ((uint8_t*)(rrset->rrs[i].rdatas[0].data + 1))[1] == '2') {
+			version_2_found = 1;
+			break;
 		}
-		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "Added catalog "
-			"member zone %s (from %s)",
-			member_domain_str, domain_to_string(member_id)));
 	}
-delete_members:
-	while (cursor != RBTREE_NULL) {
-		/* Any current catalog member zones remaining, don't have an
-		 * member_id in the catalog anymore, so should be deleted too.
-		 */
-		struct catalog_member_zone* to_delete = cursor_cmz(cursor);
-
-		cursor = rbtree_next(cursor);
-		catalog_del_consumer_member_zone(consumer_zone, to_delete);
+	if (!version_2_found) {
+		make_catalog_consumer_invalid(consumer_zone,
+			"'version.%s' TXT RR with value \"2\" not found",
+			consumer_zone->options->name);
+		return;
 	}
-	if(mode == retry_to_add) {
-		mode = just_add;
-		goto retry_adding;
+	/* collect the changes to the member zones, then apply them */
+	region = region_create(xalloc, free);
+	catalog_member_delta_init(&delta);
+	if(!catalog_consumer_member_delta(consumer_zone, zone, region,
+			&delta)) {
+		region_destroy(region);
+		return;
 	}
+	catalog_consumer_apply_delta(consumer_zone, &delta);
+	region_destroy(region);
 	debug_log_consumer_members(consumer_zone);
 	make_catalog_consumer_valid(consumer_zone);
 }
@@ -1008,7 +1024,7 @@ int
 xfrd_del_catalog_producer_member(struct xfrd_state* xfrd,
 		const dname_type* member_zone_name)
 {
-	struct xfrd_producer_member* to_delete;
+	struct xfrd_producer_member* to_delete, **to_add;
 	struct catalog_member_zone* cmz;
 	struct xfrd_catalog_producer_zone* producer_zone;
 
@@ -1017,10 +1033,25 @@ xfrd_del_catalog_producer_member(struct xfrd_state* xfrd,
 	|| !(producer_zone = xfrd_get_catalog_producer_zone(cmz))
 	|| !rbtree_delete(&producer_zone->member_ids, cmz))
 		return 0;
+	cmz->node = *RBTREE_NULL;
+	/* A member that is still on the to_add stack is not in the producer
+	 * zone yet. Take it off the stack, there is nothing to delete. */
+	for(to_add = &producer_zone->to_add; *to_add;
+			to_add = &(*to_add)->next) {
+		struct xfrd_producer_member* pending = *to_add;
+		if(pending->member_id != cmz->member_id)
+			continue;
+		*to_add = pending->next;
+		region_recycle(xfrd->region, pending, sizeof(*pending));
+		region_recycle( xfrd->nsd->options->region
+		              , (void *)cmz->member_id
+		              , dname_total_size(cmz->member_id));
+		cmz->member_id = NULL;
+		return 0;
+	}
 	to_delete = (struct xfrd_producer_member*)region_alloc(xfrd->region,
 			sizeof(struct xfrd_producer_member));
 	to_delete->member_id = cmz->member_id; cmz->member_id = NULL;
-	cmz->node = *RBTREE_NULL;
 	to_delete->member_zone_name = member_zone_name;
 	to_delete->group_name = cmz->options.pattern->pname;
 	to_delete->next = producer_zone->to_delete;
@@ -1175,6 +1206,20 @@ xfr_writer_commit(struct xfrd_xfr_writer* xw, const char *fmt, ...)
 	xfrd_set_reload_now(xfrd);
 }
 
+/** recycle a member popped from the to_delete stack */
+static void
+xfrd_producer_member_recycle_deleted(struct xfrd_producer_member* to_delete)
+{
+	region_recycle( xfrd->nsd->options->region
+	              , (void *)to_delete->member_id
+	              , dname_total_size(to_delete->member_id));
+	region_recycle( xfrd->region /* allocated in perform_delzone */
+	              , (void *)to_delete->member_zone_name
+	              , dname_total_size(to_delete->member_zone_name));
+	/* Don't recycle to_delete->group_name it's pattern->pname */
+	region_recycle( xfrd->region, to_delete, sizeof(*to_delete));
+}
+
 static void
 xfrd_process_catalog_producer_zone(
 		struct xfrd_catalog_producer_zone* producer_zone)
@@ -1191,14 +1236,43 @@ xfrd_process_catalog_producer_zone(
 	xfr_writer_add_SOA(&xw, producer_name, xw.new_serial);
 
 	if(xw.old_serial == 0) {
-		/* initial deployment */
-		assert(producer_zone->to_add && !producer_zone->to_delete);
+		/* initial deployment, or the served zone could not be kept
+		 * up to date. Write the zone with all the current member
+		 * zones, that includes the changes on the stacks.
+		 */
+		rbnode_type* node;
 
 		xfr_writer_add_RR (&xw, producer_name
 		                      , TYPE_NS, 9, "\007invalid\000");
 		xfr_writer_add_TXT(&xw, label_plus_dname("version"
 		                                        , producer_name), "2");
-		goto add_member_zones;
+		for(node = rbtree_first(&producer_zone->member_ids)
+		   ; node != RBTREE_NULL; node = rbtree_next(node)) {
+			struct catalog_member_zone* cmz =
+				(struct catalog_member_zone*)node->key;
+
+			xfr_writer_add_PTR(&xw, cmz->member_id,
+				(const dname_type*)cmz->options.node.key);
+			xfr_writer_add_TXT( &xw
+					  , label_plus_dname("group"
+							    , cmz->member_id)
+					  , cmz->options.pattern->pname);
+		}
+		while(producer_zone->to_delete) {
+			struct xfrd_producer_member* to_delete =
+				producer_zone->to_delete;
+
+			producer_zone->to_delete = to_delete->next;
+			xfrd_producer_member_recycle_deleted(to_delete);
+		}
+		while(producer_zone->to_add) {
+			struct xfrd_producer_member* to_add =
+				producer_zone->to_add;
+
+			producer_zone->to_add = to_add->next;
+			region_recycle(xfrd->region, to_add, sizeof(*to_add));
+		}
+		goto commit;
 	} 
 	/* IXFR */
 	xfr_writer_add_SOA(&xw, producer_name, xw.old_serial);
@@ -1220,18 +1294,10 @@ xfrd_process_catalog_producer_zone(
 						    , to_delete->member_id)
 				  , to_delete->group_name);
 
-		region_recycle( xfrd->nsd->options->region
-		              , (void *)to_delete->member_id
-			      , dname_total_size(to_delete->member_id));
-		region_recycle( xfrd->region /* allocated in perform_delzone */
-		              , (void *)to_delete->member_zone_name
-			      , dname_total_size(to_delete->member_zone_name));
-		/* Don't recycle to_delete->group_name it's pattern->pname */
-		region_recycle( xfrd->region, to_delete, sizeof(*to_delete));
+		xfrd_producer_member_recycle_deleted(to_delete);
 	}
 	xfr_writer_add_SOA(&xw, producer_name, xw.new_serial);
 
-add_member_zones:
 	while(producer_zone->to_add) {
 		struct xfrd_producer_member* to_add = producer_zone->to_add;
 
@@ -1254,9 +1320,11 @@ add_member_zones:
 		 */
 		region_recycle(xfrd->region, to_add, sizeof(*to_add));
 	}
+commit:
 	xfr_writer_add_SOA(&xw, producer_name, xw.new_serial);
-	xfr_writer_commit(&xw, "xfr for catalog producer zone "
+	xfr_writer_commit(&xw, "%s for catalog producer zone "
 			"'%s' with %d members from %u to %u",
+			(xw.old_serial ? "ixfr" : "axfr"),
 			dname_to_string(producer_name, NULL),
 			producer_zone->member_ids.count,
 			xw.old_serial, xw.new_serial);
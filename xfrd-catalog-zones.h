@@ -117,6 +117,8 @@ void xfrd_add_catalog_producer_member(struct catalog_member_zone* cmz);
  * constructed xfr. Return 1 if zone is deleted. In this case, member_zone_name
  * is taken over by xfrd and cannot be recycled by the caller. member_zone_name
  * must have been allocated int the xfrd->nsd->options->region
+ * A member that was added, but not yet written to the producer zone, is
+ * dropped from the pending additions, and 0 is returned.
  */
 int xfrd_del_catalog_producer_member(xfrd_state_type* xfrd,
 		const dname_type* dname);
@@ -21,12 +21,19 @@
 #include "nsd.h"
 #include "options.h"
 
+/* if true, the last token read is returned again by the next read */
+static int xfrd_token_pushback = 0;
+
 /* quick tokenizer, reads words separated by whitespace.
    No quoted strings. Comments are skipped (#... eol). */
 static char*
 xfrd_read_token(FILE* in)
 {
 	static char buf[4000];
+	if(xfrd_token_pushback) {
+		xfrd_token_pushback = 0;
+		return buf;
+	}
 	buf[sizeof(buf)-1]=0;
 	while(1) {
 		if(fscanf(in, " %3990s", buf) != 1)
@@ -86,6 +93,32 @@ xfrd_read_check_str(FILE* in, const char* str)
 	return 1;
 }
 
+/* read the optional primary round trip times, rtt_num is 0 if absent */
+static int
+xfrd_read_state_rtt(FILE* in, region_type* region, uint32_t* rtt_num,
+	uint32_t** rtt)
+{
+	uint32_t n;
+	char* p = xfrd_read_token(in);
+	*rtt_num = 0;
+	*rtt = NULL;
+	if(!p)
+		return 1; /* the next read fails on the end of file */
+	if(strcmp(p, "rtt:") != 0) {
+		xfrd_token_pushback = 1;
+		return 1;
+	}
+	if(!xfrd_read_i32(in, rtt_num) || *rtt_num > 65536)
+		return 0;
+	*rtt = (uint32_t*)region_alloc_array(region, *rtt_num+1,
+		sizeof(uint32_t));
+	for(n=0; n<*rtt_num; n++) {
+		if(!xfrd_read_i32(in, &(*rtt)[n]))
+			return 0;
+	}
+	return 1;
+}
+
 static int
 xfrd_read_state_soa(FILE* in, const char* id_acquired,
 	const char* id, xfrd_soa_type* soa, time_t* soatime)
@@ -148,10 +181,13 @@ xfrd_read_state(struct xfrd_state* xfrd)
 	uint32_t numzones, i;
 	region_type *tempregion;
 	time_t soa_refresh;
+	const char* magic;
+	char* p;
 
 	tempregion = region_create(xalloc, free);
 	if(!tempregion)
 		return;
+	xfrd_token_pushback = 0;
 
 	in = fopen(statefile, "r");
 	if(!in) {
@@ -165,7 +201,8 @@ xfrd_read_state(struct xfrd_state* xfrd)
 		region_destroy(tempregion);
 		return;
 	}
-	if(!xfrd_read_check_str(in, XFRD_FILE_MAGIC)) {
+	if(!(p = xfrd_read_token(in)) || (strcmp(p, XFRD_FILE_MAGIC) != 0 &&
+		strcmp(p, XFRD_FILE_MAGIC_V2) != 0)) {
 		/* older file version; reset everything */
 		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd: file %s is old version. refreshing all zones.",
 			statefile));
@@ -173,6 +210,9 @@ xfrd_read_state(struct xfrd_state* xfrd)
 		region_destroy(tempregion);
 		return;
 	}
+	/* the file ends with the magic it starts with */
+	magic = strcmp(p, XFRD_FILE_MAGIC) == 0 ? XFRD_FILE_MAGIC :
+		XFRD_FILE_MAGIC_V2;
 	if(!xfrd_read_check_str(in, "filetime:") ||
 	   !xfrd_read_i32(in, &filetime) ||
 	   (time_t)filetime > xfrd_time()+15 ||
@@ -187,10 +227,10 @@ xfrd_read_state(struct xfrd_state* xfrd)
 	}
 
 	for(i=0; i<numzones; i++) {
-		char *p;
 		xfrd_zone_type* zone;
 		const dname_type* dname;
 		uint32_t state, masnum, nextmas, round_num, timeout, backoff;
+		uint32_t rtt_num, *rtt, n;
 		xfrd_soa_type soa_nsd_read, soa_disk_read, soa_notified_read;
 		time_t soa_nsd_acquired_read,
 			soa_disk_acquired_read, soa_notified_acquired_read;
@@ -228,7 +268,8 @@ xfrd_read_state(struct xfrd_state* xfrd)
 		   !xfrd_read_state_soa(in, "soa_disk_acquired:", "soa_disk:",
 			&soa_disk_read, &soa_disk_acquired_read) ||
 		   !xfrd_read_state_soa(in, "soa_notify_acquired:", "soa_notify:",
-			&soa_notified_read, &soa_notified_acquired_read))
+			&soa_notified_read, &soa_notified_acquired_read) ||
+		   !xfrd_read_state_rtt(in, tempregion, &rtt_num, &rtt))
 		{
 			log_msg(LOG_ERR, "xfrd: corrupt state file %s dated %d (now=%lld)",
 				statefile, (int)filetime, (long long)xfrd_time());
@@ -270,6 +311,13 @@ xfrd_read_state(struct xfrd_state* xfrd)
 			zone->master_num = 0;
 			zone->round_num = 0;
 		}
+		for(n=0; n<rtt_num; n++) {
+			if(!acl_find_num(zone->zone_options->pattern->
+				request_xfr, (int)n))
+				break;
+			if(xfrd_master_rtt(zone, (int)n) == 0)
+				xfrd_set_master_rtt(zone, (int)n, (int)rtt[n]);
+		}
 
 		/*
 		 * There is no timeout,
@@ -345,7 +393,7 @@ xfrd_read_state(struct xfrd_state* xfrd)
 			xfrd_handle_incoming_soa(zone, &incoming_soa, incoming_acquired);
 	}
 
-	if(!xfrd_read_check_str(in, XFRD_FILE_MAGIC)) {
+	if(!xfrd_read_check_str(in, magic)) {
 		log_msg(LOG_ERR, "xfrd: corrupt state file %s dated %d (now=%lld)",
 			statefile, (int)filetime, (long long)xfrd_time());
 		region_destroy(tempregion);
@@ -446,6 +494,23 @@ xfrd_write_state_soa(FILE* out, const char* id,
 	fprintf(out, "\n");
 }
 
+/* write the primary round trip times, if any are known */
+static void
+xfrd_write_state_rtt(FILE* out, xfrd_zone_type* zone)
+{
+	int i, known = 0;
+	for(i=0; i<zone->master_rtt_num; i++) {
+		if(zone->master_rtt[i] != 0)
+			known = 1;
+	}
+	if(!known)
+		return;
+	fprintf(out, "\trtt: %d", zone->master_rtt_num);
+	for(i=0; i<zone->master_rtt_num; i++)
+		fprintf(out, " %d", zone->master_rtt[i]);
+	fprintf(out, "\t# msec per primary\n");
+}
+
 void
 xfrd_write_state(struct xfrd_state* xfrd)
 {
@@ -508,6 +573,7 @@ xfrd_write_state(struct xfrd_state* xfrd)
 			zone->soa_disk_acquired, zone->apex);
 		xfrd_write_state_soa(out, "soa_notify", &zone->soa_notified,
 			zone->soa_notified_acquired, zone->apex);
+		xfrd_write_state_rtt(out, zone);
 		fprintf(out, "\n");
 	}
 
@@ -14,7 +14,9 @@ struct xfrd_state;
 struct nsd;
 
 /* magic string to identify xfrd state file */
-#define XFRD_FILE_MAGIC "NSDXFRD2"
+#define XFRD_FILE_MAGIC "NSDXFRD3"
+/* the previous version, without the rtt lines, is read as well */
+#define XFRD_FILE_MAGIC_V2 "NSDXFRD2"
 
 /* read from state file as many zones as possible (until error/eof).*/
 void xfrd_read_state(struct xfrd_state* xfrd);
@@ -16,6 +16,7 @@
 #include "xfrd.h"
 #include "xfrd-tcp.h"
 #include "packet.h"
+#include "nsd.h"
 
 #define XFRD_NOTIFY_RETRY_TIMOUT 3 /* seconds between retries sending NOTIFY */
 
@@ -64,7 +65,7 @@ notify_disable(struct notify_zone* zone)
 		notify_send6_disable(zone);
 	}
 
-	if(xfrd->notify_udp_num == XFRD_MAX_UDP_NOTIFY) {
+	if(xfrd->notify_udp_num <= xfrd->nsd->options->xfrd_notify_max) {
 		/* find next waiting and needy zone */
 		while(xfrd->notify_waiting_first) {
 			/* snip off */
@@ -182,7 +183,7 @@ reply_pkt_is_ack(struct notify_zone* zone, buffer_type* packet, int index)
 }
 
 /* compare sockaddr and acl_option addr and port numbers */
-static int
+int
 cmp_addr_equal(struct sockaddr* a, socklen_t a_len, struct acl_options* dest)
 {
 	if(dest) {
@@ -353,15 +354,46 @@ notify_timeout_check(struct notify_zone* zone)
 	}
 }
 
+/* see if a notify can be sent to the secondary within the rate limit,
+ * if so it is counted */
+static int
+notify_rate_check(struct acl_options* dest)
+{
+	int limit = xfrd->nsd->options->xfrd_notify_rate_limit;
+	struct xfrd_addr_rate* r;
+	time_t now;
+	if(limit <= 0)
+		return 1;
+	r = xfrd_addr_rate_find(xfrd->notify_rates, dest->ip_address_spec);
+	now = xfrd_time();
+	if(r->second != now) {
+		r->second = now;
+		r->count = 0;
+	}
+	if(r->count >= limit)
+		return 0;
+	r->count++;
+	return 1;
+}
+
 static void
 notify_start_pkts(struct notify_zone* zone)
 {
 	int i;
+	zone->notify_paced = 0;
 	if(!zone->notify_current) return; /* no more acl to send to */
 	for(i=0; i<NOTIFY_CONCURRENT_MAX; i++) {
 		/* while loop, in case the retries all fail, and we can
 		 * start another on this slot, or run out of notify acls */
 		while(zone->pkts[i].dest==NULL && zone->notify_current) {
+			if(!notify_rate_check(zone->notify_current)) {
+				/* continue in the next second */
+				DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd: zone %s: "
+					"notify to %s paced", zone->apex_str,
+					zone->notify_current->ip_address_spec));
+				zone->notify_paced = 1;
+				return;
+			}
 			zone->pkts[i].dest = zone->notify_current;
 			zone->notify_current = zone->notify_current->next;
 			zone->pkts[i].notify_retry = 0;
@@ -378,12 +410,33 @@ notify_start_pkts(struct notify_zone* zone)
 static void
 notify_setup_event(struct notify_zone* zone)
 {
+	/* paced notifies continue in the next second */
+	int timeout = zone->notify_paced?1:XFRD_NOTIFY_RETRY_TIMOUT;
+	if(zone->notify_send_handler.ev_fd == -1 &&
+		zone->notify_send6_handler.ev_fd == -1) {
+		/* nothing sent yet, wait for the rate limit with a timer */
+		if(zone->notify_send_enable) {
+			event_del(&zone->notify_send_handler);
+		}
+		zone->notify_timeout.tv_sec = timeout;
+		zone->notify_timeout.tv_usec = 0;
+		memset(&zone->notify_send_handler, 0,
+			sizeof(zone->notify_send_handler));
+		event_set(&zone->notify_send_handler, -1, EV_TIMEOUT,
+			xfrd_handle_notify_send, zone);
+		if(event_base_set(xfrd->event_base, &zone->notify_send_handler) != 0)
+			log_msg(LOG_ERR, "notify_send: event_base_set failed");
+		if(evtimer_add(&zone->notify_send_handler, &zone->notify_timeout) != 0)
+			log_msg(LOG_ERR, "notify_send: evtimer_add failed");
+		zone->notify_send_enable = 1;
+		return;
+	}
 	if(zone->notify_send_handler.ev_fd != -1) {
 		int fd = zone->notify_send_handler.ev_fd;
 		if(zone->notify_send_enable) {
 			event_del(&zone->notify_send_handler);
 		}
-		zone->notify_timeout.tv_sec = XFRD_NOTIFY_RETRY_TIMOUT;
+		zone->notify_timeout.tv_sec = timeout;
 		memset(&zone->notify_send_handler, 0,
 			sizeof(zone->notify_send_handler));
 		event_set(&zone->notify_send_handler, fd, EV_READ | EV_TIMEOUT,
@@ -399,7 +452,7 @@ notify_setup_event(struct notify_zone* zone)
 		if(zone->notify_send6_enable) {
 			event_del(&zone->notify_send6_handler);
 		}
-		zone->notify_timeout.tv_sec = XFRD_NOTIFY_RETRY_TIMOUT;
+		zone->notify_timeout.tv_sec = timeout;
 		memset(&zone->notify_send6_handler, 0,
 			sizeof(zone->notify_send6_handler));
 		event_set(&zone->notify_send6_handler, fd, EV_READ | EV_TIMEOUT,
@@ -412,6 +465,43 @@ notify_setup_event(struct notify_zone* zone)
 	}
 }
 
+/* add the time the notify took to the histogram */
+static void
+notify_time_add(struct notify_zone* zone)
+{
+	struct timespec now;
+	uint64_t msec;
+	int b = 0;
+	get_time(&now);
+	timespec_subtract(&now, &zone->notify_queued);
+	if(now.tv_sec < 0)
+		return;
+	msec = (uint64_t)now.tv_sec*1000 + now.tv_nsec/1000000;
+	while(msec && b < XFRD_NOTIFY_TIME_BUCKETS-1) {
+		msec >>= 1;
+		b++;
+	}
+	xfrd->notify_time_hist[b]++;
+}
+
+uint64_t
+notify_time_percentile(struct xfrd_state* xfrd, int percent)
+{
+	uint64_t total = 0, count = 0;
+	int b;
+	for(b=0; b<XFRD_NOTIFY_TIME_BUCKETS; b++)
+		total += xfrd->notify_time_hist[b];
+	if(total == 0)
+		return 0;
+	for(b=0; b<XFRD_NOTIFY_TIME_BUCKETS; b++) {
+		count += xfrd->notify_time_hist[b];
+		/* the upper bound of the bucket */
+		if(count*100 >= total*(uint64_t)percent)
+			return ((uint64_t)1)<<b;
+	}
+	return ((uint64_t)1)<<(XFRD_NOTIFY_TIME_BUCKETS-1);
+}
+
 static void
 xfrd_handle_notify_send(int fd, short event, void* arg)
 {
@@ -453,6 +543,7 @@ xfrd_handle_notify_send(int fd, short event, void* arg)
 		DEBUG(DEBUG_XFRD,1, (LOG_INFO,
 			"xfrd: zone %s: no more notify-send acls. stop notify.",
 			zone->apex_str));
+		notify_time_add(zone);
 		notify_disable(zone);
 		return;
 	}
@@ -496,7 +587,8 @@ notify_enable(struct notify_zone* zone, struct xfrd_soa* new_soa)
 	if(zone->is_waiting)
 		return;
 
-	if(xfrd->notify_udp_num < XFRD_MAX_UDP_NOTIFY) {
+	get_time(&zone->notify_queued);
+	if(xfrd->notify_udp_num < xfrd->nsd->options->xfrd_notify_max) {
 		setup_notify_active(zone);
 		xfrd->notify_udp_num++;
 		return;
@@ -68,6 +68,10 @@ struct notify_zone {
 	uint8_t notify_restart; /* restart notify after repattern */
 	struct notify_pkt pkts[NOTIFY_CONCURRENT_MAX];
 	int notify_pkt_count; /* number of entries nonNULL in pkts */
+	/* a secondary is over its rate limit, the rest is sent later */
+	uint8_t notify_paced;
+	/* when the notify was started, for the notify time histogram */
+	struct timespec notify_queued;
 
 	/* is this notify waiting for a socket? */
 	uint8_t is_waiting;
@@ -76,6 +80,9 @@ struct notify_zone {
 	struct notify_zone* waiting_prev;
 } ATTR_PACKED;
 
+/* msec in which the percentage of notifies was done, from histogram */
+uint64_t notify_time_percentile(struct xfrd_state* xfrd, int percent);
+
 /* initialise outgoing notifies */
 void init_notify_send(rbtree_type* tree, region_type* region,
 	struct zone_options* options);
@@ -97,5 +104,8 @@ void notify_handle_master_zone_soainfo(rbtree_type* tree,
 void close_notify_fds(rbtree_type* tree);
 /* stop send of notify */
 void notify_disable(struct notify_zone* zone);
+/* compare sockaddr and acl_option addr and port numbers */
+int cmp_addr_equal(struct sockaddr* a, socklen_t a_len,
+	struct acl_options* dest);
 
 #endif /* XFRD_NOTIFY_H */
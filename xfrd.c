@@ -100,6 +100,13 @@ static void xfrd_write_timer_set(void);
 
 static void xfrd_free_zone_xfr(xfrd_zone_type* zone, xfrd_xfr_type* xfr);
 
+/* send SOA queries to all primaries of the zone, true if started */
+static int xfrd_probe_start(xfrd_zone_type* zone);
+/* the zone no longer waits for a slot in the primary rate limit */
+static void xfrd_request_undefer(xfrd_zone_type* zone);
+/* spread the refreshes of the activated zones that have data */
+static void xfrd_startup_spread(void);
+
 static void
 xfrd_signal_callback(int sig, short event, void* ATTR_UNUSED(arg))
 {
@@ -152,6 +159,16 @@ xfrd_init(int socket, struct nsd* nsd, int shortsoa, int reload_active,
 	xfrd->udp_waiting_first = NULL;
 	xfrd->udp_waiting_last = NULL;
 	xfrd->udp_use_num = 0;
+	xfrd->probe_udp_num = 0;
+	xfrd->primary_rates = rbtree_create(xfrd->region,
+		(int (*)(const void *, const void *)) strcmp);
+	xfrd->notify_rates = rbtree_create(xfrd->region,
+		(int (*)(const void *, const void *)) strcmp);
+	memset(xfrd->notify_time_hist, 0, sizeof(xfrd->notify_time_hist));
+	xfrd->request_deferred_num = 0;
+	xfrd->load_pending_region = region_create(xalloc, free);
+	xfrd->load_pending = rbtree_create(xfrd->load_pending_region,
+		(int (*)(const void *, const void *)) dname_compare);
 	xfrd->got_time = 0;
 	xfrd->xfrfilenumber = 0;
 #ifdef USE_ZONE_STATS
@@ -208,9 +225,16 @@ xfrd_init(int socket, struct nsd* nsd, int shortsoa, int reload_active,
 
 	DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd pre-startup"));
 	xfrd_init_zones();
+	/* a zone list file with more deleted than used lines is compacted
+	 * here, where the file is written, so the next start reads less */
+	if(nsd->options->zonelist && nsd->options->zonefree_number >
+		nsd->options->zone_options->count)
+		zone_list_compact(nsd->options);
 	xfrd_receive_soa(socket, shortsoa);
 	if(nsd->options->xfrdfile != NULL && nsd->options->xfrdfile[0]!=0)
 		xfrd_read_state(xfrd);
+	if(nsd->options->xfrd_startup_spread)
+		xfrd_startup_spread();
 	
 	/* did we get killed before startup was successful? */
 	if(nsd->signal_hint_shutdown) {
@@ -436,6 +460,7 @@ xfrd_shutdown()
 			while(z->latest_xfr != NULL) {
 				xfrd_free_zone_xfr(z, z->latest_xfr);
 			}
+			xfrd_clear_master_rtt(z);
 		}
 	}
 	if(xfrd->notify_zones) {
@@ -460,6 +485,7 @@ xfrd_shutdown()
 	udb_base_free(nsd.task[0]);
 	udb_base_free(nsd.task[1]);
 	event_base_free(xfrd->event_base);
+	region_destroy(xfrd->load_pending_region);
 	region_destroy(xfrd->region);
 	nsd_options_destroy(nsd.options);
 	region_destroy(nsd.region);
@@ -500,11 +526,19 @@ xfrd_init_slave_zone(xfrd_state_type* xfrd, struct zone_options* zone_opt)
 	xzone->master = xzone->zone_options->pattern->request_xfr;
 	xzone->master_num = 0;
 	xzone->next_master = 0;
+	if(zone_opt->pattern->probe_primaries) {
+		/* first probe all masters */
+		xzone->next_master = -1;
+		xzone->round_num = -1;
+	}
 	xzone->fresh_xfr_timeout = XFRD_TRANSFER_TIMEOUT_START;
 
 	xzone->soa_nsd_acquired = 0;
 	xzone->soa_disk_acquired = 0;
 	xzone->latest_xfr = NULL;
+	xzone->probes = NULL;
+	xzone->master_rtt = NULL;
+	xzone->master_rtt_num = 0;
 	xzone->soa_notified_acquired = 0;
 	/* [0]=1, [1]=0; "." domain name */
 	xzone->soa_nsd.prim_ns[0] = 1;
@@ -1010,6 +1044,9 @@ xfrd_del_slave_zone(xfrd_state_type* xfrd, const dname_type* dname)
 		z->udp_waiting = 0;
 	}
 	xfrd_deactivate_zone(z);
+	xfrd_probe_stop(z);
+	xfrd_clear_master_rtt(z);
+	xfrd_request_undefer(z);
 	if(z->tcp_conn != -1) {
 		xfrd_tcp_release(xfrd->tcp_set, z);
 	} else if(z->zone_handler.ev_fd != -1 && z->event_added) {
@@ -1175,9 +1212,450 @@ xfrd_handle_zone(int ATTR_UNUSED(fd), short event, void* arg)
 	}
 }
 
+int
+xfrd_master_rtt(xfrd_zone_type* zone, int num)
+{
+	if(num < 0 || num >= zone->master_rtt_num)
+		return 0;
+	return zone->master_rtt[num];
+}
+
+void
+xfrd_set_master_rtt(xfrd_zone_type* zone, int num, int rtt)
+{
+	if(num < 0)
+		return;
+	if(num >= zone->master_rtt_num) {
+		zone->master_rtt = (int*)xrealloc(zone->master_rtt,
+			sizeof(int)*(num+1));
+		memset(zone->master_rtt + zone->master_rtt_num, 0,
+			sizeof(int)*(num+1-zone->master_rtt_num));
+		zone->master_rtt_num = num+1;
+	}
+	zone->master_rtt[num] = rtt;
+}
+
+void
+xfrd_clear_master_rtt(xfrd_zone_type* zone)
+{
+	free(zone->master_rtt);
+	zone->master_rtt = NULL;
+	zone->master_rtt_num = 0;
+}
+
+/** update the smoothed round trip time to the master, in msec */
+static void
+xfrd_update_rtt(xfrd_zone_type* zone, int master_num, struct timeval* sent)
+{
+	struct timeval now;
+	int ms, rtt;
+	if(gettimeofday(&now, NULL) == -1)
+		return;
+	ms = (int)((now.tv_sec - sent->tv_sec)*1000 +
+		(now.tv_usec - sent->tv_usec)/1000);
+	if(ms < 1)
+		ms = 1;
+	rtt = xfrd_master_rtt(zone, master_num);
+	if(rtt == 0)
+		rtt = ms;
+	else	rtt = (7*rtt + ms)/8;
+	xfrd_set_master_rtt(zone, master_num, rtt);
+}
+
+/** close the socket of the probe, it is done */
+static void
+xfrd_probe_close(xfrd_probe_type* probe)
+{
+	if(probe->fd == -1)
+		return;
+	event_del(&probe->handler);
+	close(probe->fd);
+	probe->fd = -1;
+	tsig_delete_record(&probe->tsig, NULL);
+	xfrd->probe_udp_num--;
+	probe->zone->probe_pending--;
+}
+
+void
+xfrd_probe_stop(xfrd_zone_type* zone)
+{
+	int i;
+	if(!zone->probes)
+		return;
+	for(i=0; i<zone->probe_num; i++)
+		xfrd_probe_close(&zone->probes[i]);
+	free(zone->probes);
+	zone->probes = NULL;
+	zone->probe_num = 0;
+	zone->probe_pending = 0;
+}
+
+/** all probes are done, pick the master to request the transfer from */
+static void
+xfrd_probe_done(xfrd_zone_type* zone)
+{
+	xfrd_probe_type* best = NULL;
+	int i;
+	for(i=0; i<zone->probe_num; i++) {
+		xfrd_probe_type* p = &zone->probes[i];
+		if(!p->have_serial)
+			continue;
+		if(!best || compare_serial(p->serial, best->serial) > 0 ||
+			(p->serial == best->serial &&
+			xfrd_master_rtt(zone, p->master_num) <
+			xfrd_master_rtt(zone, best->master_num)))
+			best = p;
+	}
+	if(best) {
+		VERBOSITY(2, (LOG_INFO, "xfrd: zone %s probed %d primaries, "
+			"use %s with serial %u rtt %d msec", zone->apex_str,
+			zone->probe_num, best->master->ip_address_spec,
+			(unsigned)best->serial,
+			xfrd_master_rtt(zone, best->master_num)));
+		zone->next_master = best->master_num;
+	} else {
+		VERBOSITY(2, (LOG_INFO, "xfrd: zone %s probed %d primaries, "
+			"no answers", zone->apex_str, zone->probe_num));
+		/* use the first, and cycle as usual */
+		zone->next_master = 0;
+	}
+	xfrd_probe_stop(zone);
+	xfrd_make_request(zone);
+}
+
+/** see if the packet is a reply to the probe, from the primary and with
+ * the query ID. Other packets are ignored and the probe keeps waiting. */
+static int
+xfrd_probe_is_reply(xfrd_probe_type* probe, buffer_type* packet,
+	struct sockaddr* src, socklen_t srclen)
+{
+	return buffer_limit(packet) >= QHEADERSZ &&
+		ID(packet) == probe->query_id && QR(packet) &&
+		cmp_addr_equal(src, srclen, probe->master);
+}
+
+/** verify the TSIG of the probe reply, if the primary has a key, and
+ * strip it from the packet. Returns false if the TSIG is bad or missing */
+static int
+xfrd_probe_process_tsig(xfrd_probe_type* probe, buffer_type* packet)
+{
+	tsig_record_type* tsig = &probe->tsig;
+	if(!probe->master->key_options || !probe->master->key_options->tsig_key)
+		return 1;
+	if(!tsig->algorithm)
+		return 0; /* the query was not signed, error already printed */
+	if(!tsig_find_rr(tsig, packet) || tsig->status != TSIG_OK) {
+		log_msg(LOG_ERR, "xfrd: zone %s, from %s: probe reply without "
+			"valid tsig RR", probe->zone->apex_str,
+			probe->master->ip_address_spec);
+		return 0;
+	}
+	if(tsig->error_code != TSIG_ERROR_NOERROR) {
+		log_msg(LOG_ERR, "xfrd: zone %s, from %s: tsig error (%s)",
+			probe->zone->apex_str, probe->master->ip_address_spec,
+			tsig_error(tsig->error_code));
+		return 0;
+	}
+	buffer_set_limit(packet, tsig->position);
+	ARCOUNT_SET(packet, ARCOUNT(packet) - 1);
+	tsig_update(tsig, packet, buffer_limit(packet));
+	if(!tsig_verify(tsig)) {
+		log_msg(LOG_ERR, "xfrd: zone %s, from %s: bad tsig signature",
+			probe->zone->apex_str, probe->master->ip_address_spec);
+		return 0;
+	}
+	return 1;
+}
+
+/** parse the SOA serial from the probe reply, returns false on failure */
+static int
+xfrd_probe_parse(xfrd_probe_type* probe, buffer_type* packet)
+{
+	xfrd_soa_type soa;
+	if(RCODE(packet) != RCODE_OK || QDCOUNT(packet) != 1 ||
+		ANCOUNT(packet) == 0)
+		return 0;
+	buffer_skip(packet, QHEADERSZ);
+	if(!packet_skip_rr(packet, 1) || !packet_skip_dname(packet) ||
+		!xfrd_parse_soa_info(packet, &soa))
+		return 0;
+	probe->serial = ntohl(soa.serial);
+	probe->have_serial = 1;
+	return 1;
+}
+
+/** wait for the rest of the probe timeout after an unrelated packet,
+ * returns false if the timeout has passed */
+static int
+xfrd_probe_wait(xfrd_probe_type* probe)
+{
+	struct timeval now, tv;
+	if(gettimeofday(&now, NULL) == -1 || probe->sent.tv_sec == 0)
+		return 0;
+	tv.tv_sec = probe->sent.tv_sec + XFRD_UDP_TIMEOUT - now.tv_sec;
+	tv.tv_usec = probe->sent.tv_usec - now.tv_usec;
+	if(tv.tv_usec < 0) {
+		tv.tv_sec--;
+		tv.tv_usec += 1000000;
+	}
+	if(tv.tv_sec < 0 || (tv.tv_sec == 0 && tv.tv_usec == 0))
+		return 0;
+	if(event_add(&probe->handler, &tv) != 0) {
+		log_msg(LOG_ERR, "xfrd probe: event_add failed");
+		return 0;
+	}
+	return 1;
+}
+
+static void
+xfrd_handle_probe(int ATTR_UNUSED(fd), short event, void* arg)
+{
+	xfrd_probe_type* probe = (xfrd_probe_type*)arg;
+	xfrd_zone_type* zone = probe->zone;
+	if((event & EV_READ)) {
+		struct sockaddr_storage src;
+		socklen_t srclen = (socklen_t)sizeof(src);
+		if(!xfrd_udp_read_packet(xfrd->packet, probe->fd,
+			(struct sockaddr*)&src, &srclen)) {
+			/* error already printed */
+		} else if(!xfrd_probe_is_reply(probe, xfrd->packet,
+			(struct sockaddr*)&src, srclen)) {
+			DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd: zone %s probe to "
+				"%s, ignored packet with wrong id or source",
+				zone->apex_str, probe->master->ip_address_spec));
+			if(xfrd_probe_wait(probe))
+				return;
+		} else if(!xfrd_probe_process_tsig(probe, xfrd->packet)
+			|| !xfrd_probe_parse(probe, xfrd->packet)) {
+			DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd: zone %s bad "
+				"probe reply from %s", zone->apex_str,
+				probe->master->ip_address_spec));
+		} else {
+			xfrd_update_rtt(zone, probe->master_num,
+				&probe->sent);
+		}
+	} else {
+		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd: zone %s probe to %s "
+			"timed out", zone->apex_str,
+			probe->master->ip_address_spec));
+	}
+	xfrd_probe_close(probe);
+	if(zone->probe_pending == 0)
+		xfrd_probe_done(zone);
+}
+
+/** send the SOA query of the probe, returns false on failure */
+static int
+xfrd_probe_send(xfrd_probe_type* probe)
+{
+	struct timeval tv;
+	int apex_compress = 0;
+	xfrd_zone_type* zone = probe->zone;
+	xfrd_setup_packet(xfrd->packet, TYPE_SOA, CLASS_IN, zone->apex,
+		qid_generate(), &apex_compress);
+	probe->query_id = ID(xfrd->packet);
+	tsig_create_record_custom(&probe->tsig, NULL, 0, 0, 4);
+	if(probe->master->key_options && probe->master->key_options->tsig_key) {
+		xfrd_tsig_sign_request(xfrd->packet, &probe->tsig,
+			probe->master);
+	}
+	buffer_flip(xfrd->packet);
+	if((probe->fd = xfrd_send_udp(probe->master, xfrd->packet,
+		zone->zone_options->pattern->outgoing_interface)) == -1) {
+		tsig_delete_record(&probe->tsig, NULL);
+		return 0;
+	}
+	if(gettimeofday(&probe->sent, NULL) == -1)
+		memset(&probe->sent, 0, sizeof(probe->sent));
+	tv.tv_sec = XFRD_UDP_TIMEOUT;
+	tv.tv_usec = 0;
+	memset(&probe->handler, 0, sizeof(probe->handler));
+	event_set(&probe->handler, probe->fd, EV_READ|EV_TIMEOUT,
+		xfrd_handle_probe, probe);
+	if(event_base_set(xfrd->event_base, &probe->handler) != 0)
+		log_msg(LOG_ERR, "xfrd probe: event_base_set failed");
+	if(event_add(&probe->handler, &tv) != 0)
+		log_msg(LOG_ERR, "xfrd probe: event_add failed");
+	xfrd->probe_udp_num++;
+	zone->probe_pending++;
+	return 1;
+}
+
+static int
+xfrd_probe_start(xfrd_zone_type* zone)
+{
+	struct acl_options* m;
+	int num = 0, i;
+	if(!zone->zone_options->pattern->probe_primaries ||
+		zone->zone_options->pattern->multi_primary_check ||
+		zone->tcp_conn != -1 || zone->zone_handler.ev_fd != -1)
+		return 0;
+	for(m = zone->zone_options->pattern->request_xfr; m; m = m->next) {
+		/* XoT primaries are not probed over UDP */
+		if(m->tls_auth_options)
+			return 0;
+		num++;
+	}
+	if(num < 2 || xfrd->probe_udp_num + num > XFRD_MAX_UDP_PROBE)
+		return 0;
+
+	zone->probes = (xfrd_probe_type*)xalloc_array_zero(num,
+		sizeof(xfrd_probe_type));
+	zone->probe_num = num;
+	zone->probe_pending = 0;
+	xfrd_unset_timer(zone);
+	for(i=0, m = zone->zone_options->pattern->request_xfr; m;
+		i++, m = m->next) {
+		xfrd_probe_type* p = &zone->probes[i];
+		p->zone = zone;
+		p->master = m;
+		p->master_num = i;
+		if(!xfrd_probe_send(p))
+			p->fd = -1;
+	}
+	if(zone->probe_pending == 0) {
+		/* could not send any, use the normal cycle */
+		free(zone->probes);
+		zone->probes = NULL;
+		zone->probe_num = 0;
+		return 0;
+	}
+	DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd: zone %s probing %d primaries",
+		zone->apex_str, zone->probe_pending));
+	return 1;
+}
+
+static void
+xfrd_startup_spread(void)
+{
+	xfrd_zone_type* zone, *next;
+	int num = 0;
+	for(zone = xfrd->activated_first; zone; zone = next) {
+		time_t spread, left;
+		next = zone->activated_next;
+		/* zones without (good) data, or notified, refresh now */
+		if(!zone->soa_disk_acquired ||
+			zone->state == xfrd_zone_expired ||
+			zone->soa_notified_acquired)
+			continue;
+		spread = bound_soa_disk_refresh(zone);
+		left = (time_t)zone->soa_disk_acquired +
+			bound_soa_disk_expire(zone) - xfrd_time();
+		if(left/2 < spread)
+			spread = left/2;
+		if(spread <= 1)
+			continue;
+		if(spread > 0x7fffffff)
+			spread = 0x7fffffff;
+		xfrd_deactivate_zone(zone);
+		xfrd_set_timer(zone, (time_t)random_generate((int)spread));
+		num++;
+	}
+	VERBOSITY(2, (LOG_INFO, "xfrd: spread the refresh of %d zones", num));
+}
+
+struct xfrd_addr_rate*
+xfrd_addr_rate_find(rbtree_type* rates, const char* address)
+{
+	struct xfrd_addr_rate* r = (struct xfrd_addr_rate*)rbtree_search(
+		rates, address);
+	if(!r) {
+		r = (struct xfrd_addr_rate*)region_alloc_zero(xfrd->region,
+			sizeof(*r));
+		r->address = region_strdup(xfrd->region, address);
+		r->node.key = r->address;
+		rbtree_insert(rates, &r->node);
+	}
+	return r;
+}
+
+/** reserve a slot in the rate limit of the primary, returns the number
+ * of seconds until the slot, 0 if the request can start now */
+static time_t
+xfrd_primary_rate_slot(struct acl_options* master)
+{
+	int limit = xfrd->nsd->options->xfrd_primary_rate_limit;
+	struct xfrd_addr_rate* r;
+	time_t now;
+	if(limit <= 0)
+		return 0;
+	r = xfrd_addr_rate_find(xfrd->primary_rates, master->ip_address_spec);
+	now = xfrd_time();
+	if(r->second < now) {
+		r->second = now;
+		r->count = 0;
+	}
+	if(r->count >= limit) {
+		/* this second is full, take a slot in the next one */
+		r->second++;
+		r->count = 0;
+	}
+	r->count++;
+	return r->second - now;
+}
+
+static void
+xfrd_request_undefer(xfrd_zone_type* zone)
+{
+	if(!zone->request_deferred)
+		return;
+	zone->request_deferred = 0;
+	xfrd->request_deferred_num--;
+}
+
+/** send the request to the master of the zone */
+static void
+xfrd_request_master(xfrd_zone_type* zone)
+{
+	DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd zone %s make request round %d mr %d nx %d",
+		zone->apex_str, zone->round_num, zone->master_num, zone->next_master));
+	/* perform xfr request */
+	if (!zone->master->use_axfr_only && zone->soa_disk_acquired > 0 &&
+		!zone->master->ixfr_disabled) {
+
+		if (zone->master->allow_udp) {
+			xfrd_set_timer(zone, XFRD_UDP_TIMEOUT);
+			xfrd_udp_obtain(zone);
+		}
+		else { /* doing 3 rounds of IXFR/TCP might not be useful */
+			xfrd_set_timer(zone, xfrd->tcp_set->tcp_timeout);
+			xfrd_tcp_obtain(xfrd->tcp_set, zone);
+		}
+	}
+	else if (zone->master->use_axfr_only || zone->soa_disk_acquired <= 0) {
+		xfrd_set_timer(zone, xfrd->tcp_set->tcp_timeout);
+		xfrd_tcp_obtain(xfrd->tcp_set, zone);
+	}
+	else if (zone->master->ixfr_disabled) {
+		if (zone->zone_options->pattern->allow_axfr_fallback) {
+			xfrd_set_timer(zone, xfrd->tcp_set->tcp_timeout);
+			xfrd_tcp_obtain(xfrd->tcp_set, zone);
+		} else {
+			DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd zone %s axfr "
+				"fallback not allowed, skipping primary %s.",
+				zone->apex_str, zone->master->ip_address_spec));
+		}
+	}
+}
+
 void
 xfrd_make_request(xfrd_zone_type* zone)
 {
+	time_t wait;
+	if(zone->probes) {
+		/* the primary is picked when the SOA probes are done */
+		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd zone %s makereq waits "
+			"for probes", zone->apex_str));
+		return;
+	}
+	if(zone->request_deferred) {
+		xfrd_request_undefer(zone);
+		/* the master was picked, unless told otherwise since then */
+		if(zone->next_master == -1 && zone->round_num != -1) {
+			xfrd_request_master(zone);
+			return;
+		}
+	}
 	if(zone->next_master != -1) {
 		/* we are told to use this next master */
 		DEBUG(DEBUG_XFRD,1, (LOG_INFO,
@@ -1203,6 +1681,9 @@ xfrd_make_request(xfrd_zone_type* zone)
 			zone->master = zone->master->next;
 			zone->master_num++;
 		} else {
+			/* a fresh refresh, find the freshest primary first */
+			if(zone->round_num == -1 && xfrd_probe_start(zone))
+				return;
 			/* start a new round */
 			zone->master = zone->zone_options->pattern->request_xfr;
 			zone->master_num = 0;
@@ -1252,35 +1733,17 @@ xfrd_make_request(xfrd_zone_type* zone)
 		zone->master->ixfr_disabled = 0;
 	}
 
-	DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd zone %s make request round %d mr %d nx %d",
-		zone->apex_str, zone->round_num, zone->master_num, zone->next_master));
-	/* perform xfr request */
-	if (!zone->master->use_axfr_only && zone->soa_disk_acquired > 0 &&
-		!zone->master->ixfr_disabled) {
-
-		if (zone->master->allow_udp) {
-			xfrd_set_timer(zone, XFRD_UDP_TIMEOUT);
-			xfrd_udp_obtain(zone);
-		}
-		else { /* doing 3 rounds of IXFR/TCP might not be useful */
-			xfrd_set_timer(zone, xfrd->tcp_set->tcp_timeout);
-			xfrd_tcp_obtain(xfrd->tcp_set, zone);
-		}
-	}
-	else if (zone->master->use_axfr_only || zone->soa_disk_acquired <= 0) {
-		xfrd_set_timer(zone, xfrd->tcp_set->tcp_timeout);
-		xfrd_tcp_obtain(xfrd->tcp_set, zone);
-	}
-	else if (zone->master->ixfr_disabled) {
-		if (zone->zone_options->pattern->allow_axfr_fallback) {
-			xfrd_set_timer(zone, xfrd->tcp_set->tcp_timeout);
-			xfrd_tcp_obtain(xfrd->tcp_set, zone);
-		} else {
-			DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd zone %s axfr "
-				"fallback not allowed, skipping primary %s.",
-				zone->apex_str, zone->master->ip_address_spec));
-		}
+	/* spread the requests to the master over time */
+	if((wait = xfrd_primary_rate_slot(zone->master)) > 0) {
+		DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd zone %s request to %s "
+			"deferred %d seconds", zone->apex_str,
+			zone->master->ip_address_spec, (int)wait));
+		zone->request_deferred = 1;
+		xfrd->request_deferred_num++;
+		xfrd_set_timer(zone, wait);
+		return;
 	}
+	xfrd_request_master(zone);
 }
 
 static void
@@ -1678,6 +2141,8 @@ xfrd_udp_read(xfrd_zone_type* zone)
 		xfrd_make_request(zone);
 		return;
 	}
+	if(zone->query_sent.tv_sec != 0)
+		xfrd_update_rtt(zone, zone->master_num, &zone->query_sent);
 	switch(xfrd_handle_received_xfr_packet(zone, xfrd->packet)) {
 		case xfrd_packet_tcp:
 			xfrd_set_timer(zone, xfrd->tcp_set->tcp_timeout);
@@ -1899,6 +2364,8 @@ xfrd_send_ixfr_request_udp(xfrd_zone_type* zone)
 	xfrd_setup_packet(xfrd->packet, TYPE_IXFR, CLASS_IN, zone->apex,
 		qid_generate(), &apex_compress);
 	zone->query_id = ID(xfrd->packet);
+	if(gettimeofday(&zone->query_sent, NULL) == -1)
+		memset(&zone->query_sent, 0, sizeof(zone->query_sent));
 	xfrd_prepare_zone_xfr(zone, TYPE_IXFR);
 	DEBUG(DEBUG_XFRD,1, (LOG_INFO, "sent query with ID %d", zone->query_id));
         NSCOUNT_SET(xfrd->packet, 1);
@@ -2622,6 +3089,39 @@ xfrd_handle_notify_and_start_xfr(xfrd_zone_type* zone, xfrd_soa_type* soa)
 	}
 }
 
+void
+xfrd_clear_load_pending(void)
+{
+	if(xfrd->load_pending->count == 0)
+		return;
+	region_free_all(xfrd->load_pending_region);
+	xfrd->load_pending = rbtree_create(xfrd->load_pending_region,
+		(int (*)(const void *, const void *)) dname_compare);
+}
+
+/* have the reload read the zonefile of a zone that was queried */
+static void
+xfrd_handle_zone_load_request(const dname_type* dname)
+{
+	rbnode_type* node;
+	if(!xfrd->nsd->options->zonefiles_lazy_load ||
+		!zone_options_find(xfrd->nsd->options, dname))
+		return;
+	/* every server process sends a request for the zone, the load is
+	 * queued once */
+	if(rbtree_search(xfrd->load_pending, dname))
+		return;
+	node = (rbnode_type*)region_alloc_zero(xfrd->load_pending_region,
+		sizeof(*node));
+	node->key = dname_copy(xfrd->load_pending_region, dname);
+	rbtree_insert(xfrd->load_pending, node);
+	VERBOSITY(2, (LOG_INFO, "zone %s is queried, read its zonefile",
+		dname_to_string(dname, NULL)));
+	task_new_check_zonefiles(xfrd->nsd->task[xfrd->nsd->mytask],
+		xfrd->last_task, dname);
+	xfrd_set_reload_now(xfrd);
+}
+
 void
 xfrd_handle_passed_packet(buffer_type* packet,
 	int acl_num, int acl_num_xfr)
@@ -2642,6 +3142,13 @@ xfrd_handle_passed_packet(buffer_type* packet,
 	DEBUG(DEBUG_XFRD,1, (LOG_INFO, "xfrd: got passed packet for %s, acl "
 		   "%d", dname_to_string(dname,0), acl_num));
 
+	/* a server process saw a query for a zone that is not loaded */
+	if(OPCODE(packet) == OPCODE_QUERY) {
+		xfrd_handle_zone_load_request(dname);
+		region_destroy(tempregion);
+		return;
+	}
+
 	/* find the zone */
 	zone = (xfrd_zone_type*)rbtree_search(xfrd->zones, dname);
 	if(!zone) {
@@ -38,6 +38,10 @@ typedef struct xfrd_state xfrd_state_type;
 typedef struct xfrd_xfr xfrd_xfr_type;
 typedef struct xfrd_zone xfrd_zone_type;
 typedef struct xfrd_soa xfrd_soa_type;
+
+/* number of buckets in the histogram of notify times, up to 2^23 msec */
+#define XFRD_NOTIFY_TIME_BUCKETS 24
+
 /*
  * The global state for the xfrd daemon process.
  * The time_t times are epochs in secs since 1970, absolute times.
@@ -112,13 +116,29 @@ struct xfrd_state {
 
 	/* tree of zones, by apex name, contains xfrd_zone_type*. Only secondary zones. */
 	rbtree_type *zones;
+	/* tree of xfrd_addr_rate, by primary address, for the rate limit */
+	rbtree_type *primary_rates;
+	/* number of zones with a request deferred by the rate limit */
+	int request_deferred_num;
+	/* tree of zone apex names, with a zonefile load queued for the
+	 * reload because they were queried, in its own region. Repeated
+	 * requests from the server processes are dropped until the reload
+	 * is done. */
+	rbtree_type *load_pending;
+	struct region* load_pending_region;
 
 	/* tree of zones, by apex name, contains notify_zone*. All zones. */
 	rbtree_type *notify_zones;
+	/* number of SOA probes to primaries active using UDP socket */
+	int probe_udp_num;
 	/* number of notify_zone active using UDP socket */
 	int notify_udp_num;
 	/* first and last notify_zone* entries waiting for a UDP socket */
 	struct notify_zone *notify_waiting_first, *notify_waiting_last;
+	/* tree of xfrd_addr_rate, by secondary address, for the rate limit */
+	rbtree_type *notify_rates;
+	/* histogram of msec from notify start to done, by powers of two */
+	uint64_t notify_time_hist[XFRD_NOTIFY_TIME_BUCKETS];
 
 	/* tree of catalog consumer zones. Processing is disabled if > 1. */
 	rbtree_type *catalog_consumer_zones;
@@ -217,16 +237,61 @@ struct xfrd_zone {
 	uint8_t is_activated;
 	xfrd_zone_type* activated_next;
 	xfrd_zone_type* activated_prev;
+	/* the request to the master waits for its slot in the rate limit */
+	uint8_t request_deferred;
 
 	/* xfr message handling data */
 	/* query id */
 	uint16_t query_id;
+	/* time the udp request was sent, for the round trip time */
+	struct timeval query_sent;
 	xfrd_xfr_type *latest_xfr;
 
+	/* SOA probes to all primaries, NULL if not probing */
+	struct xfrd_probe* probes;
+	int probe_num; /* number of primaries probed */
+	int probe_pending; /* number of probes waiting for an answer */
+	/* smoothed round trip time in msec per primary number, 0 if
+	 * unknown, master_rtt_num entries */
+	int* master_rtt;
+	int master_rtt_num;
+
 	int multi_master_first_master; /* >0: first check master_num */
 	int multi_master_update_check; /* -1: not update >0: last update master_num */
 } ATTR_PACKED;
 
+/*
+ * SOA query to one of the primaries of a zone. The primaries are probed
+ * at the same time, to request the transfer from the freshest one.
+ */
+typedef struct xfrd_probe xfrd_probe_type;
+struct xfrd_probe {
+	xfrd_zone_type* zone;
+	struct acl_options* master;
+	int master_num;
+	uint16_t query_id;
+	struct timeval sent;
+	/* event for the reply or timeout, fd -1 if done */
+	struct event handler;
+	int fd;
+	tsig_record_type tsig;
+	/* the serial (host order) of the answer, if have_serial */
+	int have_serial;
+	uint32_t serial;
+};
+
+/*
+ * Packets started to an address, for xfrd-primary-rate-limit and
+ * xfrd-notify-rate-limit. The second is the latest second with reserved
+ * slots, count is the number of slots reserved in that second.
+ */
+struct xfrd_addr_rate {
+	rbnode_type node; /* key is the address */
+	const char* address;
+	time_t second;
+	int count;
+};
+
 /*
  * State for a single zone XFR
  */
@@ -267,7 +332,7 @@ enum xfrd_packet_result {
    connections. Each entry has 64Kb buffer preallocated.
 */
 #define XFRD_MAX_UDP 128 /* max number of UDP sockets at a time for IXFR */
-#define XFRD_MAX_UDP_NOTIFY 128 /* max concurrent UDP sockets for NOTIFY */
+#define XFRD_MAX_UDP_PROBE 128 /* max concurrent UDP sockets for SOA probes */
 
 #define XFRD_TRANSFER_TIMEOUT_START 10 /* empty zone timeout is between x and 2*x seconds */
 #define XFRD_TRANSFER_TIMEOUT_MAX 86400 /* empty zone timeout max expbackoff */
@@ -376,6 +441,10 @@ void xfrd_disable_ixfr(xfrd_zone_type* zone);
 /* get the current time epoch. Cached for speed. */
 time_t xfrd_time(void);
 
+/* find the rate limit state of the address in the tree, or create it */
+struct xfrd_addr_rate* xfrd_addr_rate_find(rbtree_type* rates,
+	const char* address);
+
 /*
  * Handle final received packet from network.
  * returns enum of packet discovery results
@@ -462,6 +531,17 @@ xfrd_prepare_updates_for_reload(void);
  * before the current time, so the reload happens after.
  */
 void xfrd_prepare_zones_for_reload(void);
+/* the reload is done, the zonefile load requests are no longer pending */
+void xfrd_clear_load_pending(void);
+
+/* stop the SOA probes of the zone, if any */
+void xfrd_probe_stop(xfrd_zone_type* zone);
+/* round trip time in msec to the primary number of the zone, 0 if unknown */
+int xfrd_master_rtt(xfrd_zone_type* zone, int num);
+/* set the round trip time to the primary number of the zone */
+void xfrd_set_master_rtt(xfrd_zone_type* zone, int num, int rtt);
+/* forget the round trip times of the zone, the primaries have changed */
+void xfrd_clear_master_rtt(xfrd_zone_type* zone);
 
 /* Bind a local interface to a socket descriptor, return 1 on success */
 int xfrd_bind_local_interface(int sockd, struct acl_options* ifc,
@@ -277,14 +277,8 @@ int32_t zonec_accept(
 			if (zrdatacmp(type, rdatas, rdata_count, &rrset->rrs[i]) != 0)
 				continue;
 			/* Discard the duplicates... */
-			for (size_t j = 0; j < (size_t)rdata_count; j++) {
-				size_t size;
-				if (rdata_atom_is_domain(type, j))
-					continue;
-				size = rdata_atom_size(rdatas[j]) + sizeof(uint16_t);
-				region_recycle(state->database->region, rdatas[j].data, size);
-			}
-			region_recycle(state->database->region, rdatas, sizeof(*rdatas) * rdata_count);
+			region_recycle(state->database->region, rdatas,
+				rdata_atoms_size(type, rdatas, rdata_count));
 			region_free_all(state->rr_region);
 			return 0;
 		}